@@ -47,6 +47,12 @@
 #include <unordered_map>
 #include "printutils.h"
 
+// Number of entries and their total cost, such as for one kind of entries
+struct CacheUsage {
+  size_t entries{0};
+  size_t cost{0};
+};
+
 template <class Key, class T>
 class Cache
 {
@@ -122,6 +128,11 @@ public:
   bool remove(const Key& key);
   T *take(const Key& key);
 
+  // Calls visit(key, object, cost) for each entry, most recently used first.
+  template <class F> void forEach(F visit) const {
+    for (const Node *n = f; n; n = n->n) visit(*n->keyPtr, *n->t, n->c);
+  }
+
 private:
   void trim(size_t m);
 };
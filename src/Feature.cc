@@ -40,9 +40,22 @@ const Feature Feature::ExperimentalFastCsgExactCorefinementCallback("fast-csg-ex
 #endif // FAST_CSG_KERNEL_IS_LAZY
 const Feature Feature::ExperimentalFastCsgRemesh("fast-csg-remesh", "Simplify results of fast-csg to avoid explosively slow renders (adds a bit of overhead as uses corefinement callbacks)");
 const Feature Feature::ExperimentalFastCsgRemeshPredictibly("fast-csg-remesh-predictibly", "Same as fast-csg-remesh but ensuring it remeshes faces starting from a predictable vertex. Slower but good for tests.");
+const Feature Feature::ExperimentalDoubleCsg("double-csg", "Perform CSG operations on closed manifold meshes in double precision, falling back to exact CSG for other inputs.");
+const Feature Feature::ExperimentalFastHull("fast-hull", "Compute <code>hull()</code> in floating point with quickhull, falling back to exact arithmetic for degenerate inputs.");
 const Feature Feature::ExperimentalRoof("roof", "Enable <code>roof</code>");
 const Feature Feature::ExperimentalInputDriverDBus("input-driver-dbus", "Enable DBus input drivers (requires restart)");
 const Feature Feature::ExperimentalLazyUnion("lazy-union", "Enable lazy unions.");
+const Feature Feature::ExperimentalLazyComprehensions("lazy-comprehensions", "Stream list comprehensions into <code>for</code> loops and <code>len()</code> instead of building intermediate lists.");
+const Feature Feature::ExperimentalParallelComprehensions("parallel-comprehensions", "Evaluate large side-effect free list comprehensions on multiple threads.");
+const Feature Feature::ExperimentalParallelProjection("parallel-projection", "Compute <code>projection()</code> shadows on multiple threads, leaving out faces seen from behind.");
+const Feature Feature::ExperimentalFastProjectionCut("fast-projection-cut", "Compute <code>projection(cut = true)</code> by slicing the meshes of the children, instead of intersecting their union with the plane as Nef polyhedra.");
+const Feature Feature::ExperimentalFastMinkowski("fast-minkowski", "Find the vertices of the sums of convex parts in <code>minkowski()</code> by walking along their edges, instead of summing every pair of vertices.");
+const Feature Feature::ExperimentalParallelMinkowski("parallel-minkowski", "Compute the hulls of convex part pairs in <code>minkowski()</code> on multiple threads.");
+const Feature Feature::ExperimentalParallel2dCsg("parallel-2d-csg", "Compute 2D unions and differences of many children on multiple threads.");
+const Feature Feature::ExperimentalParallelExtrude("parallel-extrude", "Build the walls of large <code>rotate_extrude()</code> results on multiple threads.");
+const Feature Feature::ExperimentalFastTessellation("fast-tessellation", "Split convex faces into triangle fans instead of tessellating them with libtess2.");
+const Feature Feature::ExperimentalParallelTessellation("parallel-tessellation", "Tessellate the faces of large meshes on multiple threads.");
+const Feature Feature::ExperimentalParallelQuantization("parallel-quantization", "Find the grid cells of the vertices of large meshes on multiple threads when quantizing them.");
 const Feature Feature::ExperimentalVxORenderers("vertex-object-renderers", "Enable vertex object renderers");
 const Feature Feature::ExperimentalVxORenderersIndexing("vertex-object-renderers-indexing", "Enable indexing in vertex object renderers");
 const Feature Feature::ExperimentalVxORenderersDirect("vertex-object-renderers-direct", "Enable direct buffer writes in vertex object renderers");
@@ -21,9 +21,22 @@ public:
   static const Feature ExperimentalFastCsgExactCorefinementCallback;
   static const Feature ExperimentalFastCsgRemesh;
   static const Feature ExperimentalFastCsgRemeshPredictibly;
+  static const Feature ExperimentalDoubleCsg;
+  static const Feature ExperimentalFastHull;
   static const Feature ExperimentalRoof;
   static const Feature ExperimentalInputDriverDBus;
   static const Feature ExperimentalLazyUnion;
+  static const Feature ExperimentalLazyComprehensions;
+  static const Feature ExperimentalParallelComprehensions;
+  static const Feature ExperimentalParallelProjection;
+  static const Feature ExperimentalFastProjectionCut;
+  static const Feature ExperimentalFastMinkowski;
+  static const Feature ExperimentalParallelMinkowski;
+  static const Feature ExperimentalParallel2dCsg;
+  static const Feature ExperimentalParallelExtrude;
+  static const Feature ExperimentalFastTessellation;
+  static const Feature ExperimentalParallelTessellation;
+  static const Feature ExperimentalParallelQuantization;
   static const Feature ExperimentalVxORenderers;
   static const Feature ExperimentalVxORenderersIndexing;
   static const Feature ExperimentalVxORenderersDirect;
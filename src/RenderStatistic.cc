@@ -27,6 +27,7 @@
 
 #include "printutils.h"
 #include "GeometryCache.h"
+#include "PrimitiveTemplateCache.h"
 #include "CGALCache.h"
 #include "PolySet.h"
 #include "Polygon2d.h"
@@ -136,6 +137,11 @@ static nlohmann::json getCache(C cache)
   cacheJson["entries"] = cache->size();
   cacheJson["bytes"] = cache->totalCost();
   cacheJson["max_size"] = cache->maxSizeMB() * 1024 * 1024;
+  auto kindsJson = nlohmann::json::object();
+  for (const auto& [kind, usage] : cache->usageByKind()) {
+    kindsJson[kind] = {{"entries", usage.entries}, {"bytes", usage.cost}};
+  }
+  cacheJson["kinds"] = kindsJson;
   return cacheJson;
 }
 
@@ -281,6 +287,7 @@ void LogVisitor::printCacheStatistic()
 {
   // always enabled
   GeometryCache::instance()->print();
+  PrimitiveTemplateCache::instance()->print();
 #ifdef ENABLE_CGAL
   CGALCache::instance()->print();
 #endif
@@ -385,6 +392,7 @@ void StreamVisitor::printCacheStatistic()
   if (is_enabled(RenderStatistic::CACHE)) {
     nlohmann::json cacheJson;
     cacheJson["geometry_cache"] = getCache(GeometryCache::instance());
+    cacheJson["primitive_cache"] = getCache(PrimitiveTemplateCache::instance());
 #ifdef ENABLE_CGAL
     cacheJson["cgal_cache"] = getCache(CGALCache::instance());
 #endif // ENABLE_CGAL
@@ -10,6 +10,7 @@
 #include "printutils.h"
 #include "GeometryEvaluator.h"
 #include "PolySet.h"
+#include "Trace.h"
 
 #include <string>
 #include <map>
@@ -26,6 +27,7 @@
 
 shared_ptr<CSGNode> CSGTreeEvaluator::buildCSGTree(const AbstractNode& node)
 {
+  Trace::Span span("csg", "buildCSGTree");
   this->traverse(node);
 
   shared_ptr<CSGNode> t(this->stored_term[node.index()]);
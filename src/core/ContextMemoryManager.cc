@@ -25,6 +25,7 @@
  */
 
 #include <deque>
+#include <iterator>
 #include <map>
 #include <unordered_set>
 
@@ -349,14 +350,16 @@ static void collectGarbage(std::vector<std::weak_ptr<Context>>& managedContexts)
 
 ContextMemoryManager::~ContextMemoryManager()
 {
-  collectGarbage(managedContexts);
+  if (garbageCollection) {
+    collectGarbage(managedContexts);
+    assert(heapSizeAccounting->size() == 0);
+  }
   assert(managedContexts.empty());
-  assert(heapSizeAccounting.size() == 0);
 }
 
 void ContextMemoryManager::addContext(const std::shared_ptr<Context>& context)
 {
-  heapSizeAccounting.addContext();
+  heapSizeAccounting->addContext();
   context->setAccountingAdded();   // avoiding bad accounting when an exception threw in constructor issue #3871
 
   /*
@@ -367,7 +370,7 @@ void ContextMemoryManager::addContext(const std::shared_ptr<Context>& context)
   if (context.use_count() > 1) {
     managedContexts.emplace_back(context);
 
-    if (heapSizeAccounting.size() >= nextGarbageCollectSize) {
+    if (garbageCollection && heapSizeAccounting->size() >= nextGarbageCollectSize) {
       collectGarbage(managedContexts);
       /*
        * The cost of a garbage collection run is proportional to the heap
@@ -378,7 +381,15 @@ void ContextMemoryManager::addContext(const std::shared_ptr<Context>& context)
        * used at any point at most twice the amount of necessary memory usage
        * (i.e. waste is at most a factor 2 overhead).
        */
-      nextGarbageCollectSize = heapSizeAccounting.size() * 2;
+      nextGarbageCollectSize = heapSizeAccounting->size() * 2;
     }
   }
 }
+
+void ContextMemoryManager::adopt(ContextMemoryManager& other)
+{
+  managedContexts.insert(managedContexts.end(),
+                         std::make_move_iterator(other.managedContexts.begin()),
+                         std::make_move_iterator(other.managedContexts.end()));
+  other.managedContexts.clear();
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -13,35 +14,58 @@ class Context;
  *
  * Counts one point for each context, each context variable, and each element
  * in a VectorType value.
+ *
+ * Objects created by worker threads may be released on other threads, so the
+ * count is atomic.
  */
 class HeapSizeAccounting
 {
 public:
-  void addContext(size_t number = 1) { count += number; }
-  void removeContext(size_t number = 1) { count -= number; }
-  void addContextVariable(size_t number = 1) { count += number; }
-  void removeContextVariable(size_t number = 1) { count -= number; }
-  void addVectorElement(size_t number = 1) { count += number; }
-  void removeVectorElement(size_t number = 1) { count -= number; }
+  void addContext(size_t number = 1) { add(number); }
+  void removeContext(size_t number = 1) { remove(number); }
+  void addContextVariable(size_t number = 1) { add(number); addValues(number); }
+  void removeContextVariable(size_t number = 1) { remove(number); }
+  void addVectorElement(size_t number = 1) { add(number); addValues(number); }
+  void removeVectorElement(size_t number = 1) { remove(number); }
 
-  [[nodiscard]] size_t size() const { return count; }
+  [[nodiscard]] size_t size() const { return count.load(std::memory_order_relaxed); }
+  // Number of Values stored in contexts and vectors so far, including released ones.
+  [[nodiscard]] size_t valuesAdded() const { return values.load(std::memory_order_relaxed); }
 
 private:
-  size_t count = 0;
+  void add(size_t number) { count.fetch_add(number, std::memory_order_relaxed); }
+  void remove(size_t number) { count.fetch_sub(number, std::memory_order_relaxed); }
+  void addValues(size_t number) { values.fetch_add(number, std::memory_order_relaxed); }
+
+  std::atomic<size_t> count{0};
+  std::atomic<size_t> values{0};
 };
 
 class ContextMemoryManager
 {
 public:
+  ContextMemoryManager() : heapSizeAccounting(&ownAccounting), garbageCollection(true) {}
+  /*
+   * A manager that counts towards shared, but doesn't collect garbage. It
+   * only records its contexts, and relies on adopt() to hand them over to the
+   * manager owning shared. This is used for worker threads, which must not
+   * clear contexts that other threads might still be reading.
+   */
+  ContextMemoryManager(HeapSizeAccounting& shared) : heapSizeAccounting(&shared), garbageCollection(false) {}
   ~ContextMemoryManager();
+  ContextMemoryManager(const ContextMemoryManager&) = delete;
+  ContextMemoryManager& operator=(const ContextMemoryManager&) = delete;
 
   void addContext(const std::shared_ptr<Context>& context);
-  void releaseContext() { heapSizeAccounting.removeContext(); }
+  void releaseContext() { heapSizeAccounting->removeContext(); }
+  void adopt(ContextMemoryManager& other);
 
-  HeapSizeAccounting& accounting() { return heapSizeAccounting; }
+  HeapSizeAccounting& accounting() { return *heapSizeAccounting; }
 
 private:
   std::vector<std::weak_ptr<Context>> managedContexts;
-  HeapSizeAccounting heapSizeAccounting;
+  HeapSizeAccounting ownAccounting;
+  HeapSizeAccounting *heapSizeAccounting;
   size_t nextGarbageCollectSize = 0;
+  bool garbageCollection;
 };
@@ -0,0 +1,129 @@
+#include "EvaluationProfiler.h"
+
+#include <algorithm>
+#include <ostream>
+#include <boost/algorithm/string/replace.hpp>
+#include <json.hpp>
+
+#include "EvaluationSession.h"
+#include "boost-utils.h"
+#include "parallel.h"
+
+EvaluationProfiler *EvaluationProfiler::active = nullptr;
+
+namespace {
+
+double milliseconds(EvaluationProfiler::clock::duration duration)
+{
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+EvaluationProfiler::EvaluationProfiler() : root{nullptr, nullptr}
+{
+}
+
+EvaluationProfiler& EvaluationProfiler::profiler()
+{
+  static EvaluationProfiler profiler;
+  return profiler;
+}
+
+void EvaluationProfiler::enable()
+{
+  active = &profiler();
+}
+
+bool EvaluationProfiler::enter(const void *id, const char *kind, const std::string& name, const Location& loc, EvaluationSession *session)
+{
+  if (Parallel::isWorker()) return false;
+
+  auto it = definitions.find(id);
+  if (it == definitions.end()) {
+    it = definitions.emplace(id, Definition{kind, name, loc}).first;
+  }
+  Definition *definition = &it->second;
+  definition->calls++;
+  definition->active++;
+
+  Node *parent = stack.empty() ? &root : stack.back().node;
+  auto& child = parent->children[definition];
+  if (!child) child = std::make_unique<Node>(Node{definition, parent});
+
+  stack.push_back(Frame{child.get(), session, clock::now(), {}, session->accounting().valuesAdded()});
+  return true;
+}
+
+void EvaluationProfiler::exit()
+{
+  assert(!stack.empty());
+  const Frame frame = stack.back();
+  stack.pop_back();
+
+  const auto elapsed = clock::now() - frame.start;
+  const auto exclusive = elapsed - frame.callees;
+  const size_t values = frame.session->accounting().valuesAdded() - frame.values_start;
+
+  Definition *definition = frame.node->definition;
+  definition->exclusive += exclusive;
+  definition->values += values > frame.callee_values ? values - frame.callee_values : 0;
+  if (--definition->active == 0) definition->inclusive += elapsed;
+  frame.node->exclusive += exclusive;
+
+  if (!stack.empty()) {
+    stack.back().callees += elapsed;
+    stack.back().callee_values += values;
+  }
+}
+
+void EvaluationProfiler::writeJson(std::ostream& stream, const std::string& docPath) const
+{
+  std::vector<const Definition *> sorted;
+  sorted.reserve(definitions.size());
+  for (const auto& entry : definitions) sorted.push_back(&entry.second);
+  std::sort(sorted.begin(), sorted.end(), [](const Definition *a, const Definition *b) {
+    return a->exclusive > b->exclusive;
+  });
+
+  nlohmann::json entries = nlohmann::json::array();
+  for (const Definition *definition : sorted) {
+    nlohmann::json entry = {
+      {"kind", definition->kind},
+      {"name", definition->name},
+      {"calls", definition->calls},
+      {"inclusive_ms", milliseconds(definition->inclusive)},
+      {"exclusive_ms", milliseconds(definition->exclusive)},
+      {"values", definition->values},
+    };
+    if (!definition->loc.isNone()) {
+      entry["file"] = boostfs_uncomplete(definition->loc.filePath(), docPath).generic_string();
+      entry["line"] = definition->loc.firstLine();
+    }
+    entries.push_back(std::move(entry));
+  }
+  stream << nlohmann::json{{"profile", entries}}.dump(4) << "\n";
+}
+
+void EvaluationProfiler::writeFolded(std::ostream& stream) const
+{
+  writeFolded(stream, root, "");
+}
+
+void EvaluationProfiler::writeFolded(std::ostream& stream, const Node& node, const std::string& prefix) const
+{
+  for (const auto& entry : node.children) {
+    const Node& child = *entry.second;
+    std::string frame = child.definition->name;
+    if (!child.definition->loc.isNone()) {
+      frame += ":" + std::to_string(child.definition->loc.firstLine());
+    }
+    boost::algorithm::replace_all(frame, ";", ",");
+    boost::algorithm::replace_all(frame, " ", "_");
+    const std::string path = prefix.empty() ? frame : prefix + ";" + frame;
+
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(child.exclusive).count();
+    if (microseconds > 0) stream << path << " " << microseconds << "\n";
+    writeFolded(stream, child, path);
+  }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AST.h"
+
+class EvaluationSession;
+
+/**
+ * Instrumenting profiler for script evaluation, enabled by --profile-eval.
+ *
+ * Records, per user function, user module and builtin, the number of calls,
+ * the inclusive and exclusive wall time, and the number of Values stored
+ * directly by it in contexts and vectors. Calls are additionally aggregated by call stack, which can
+ * be written in the folded format read by flamegraph tools.
+ *
+ * Only the main thread is profiled. Work done on worker threads, such as
+ * parallel list comprehensions, counts towards the calling frame.
+ */
+class EvaluationProfiler
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  // The active profiler, or nullptr if profiling is disabled.
+  static EvaluationProfiler *instance() { return active; }
+  static void enable();
+
+  /*
+   * Profiles the enclosing scope as a call of a definition, identified by
+   * address. Calling enter() again replaces the current call, as done for
+   * tail calls.
+   */
+  class Scope
+  {
+public:
+    Scope() = default;
+    Scope(const void *id, const char *kind, const std::string& name, const Location& loc, EvaluationSession *session) {
+      enter(id, kind, name, loc, session);
+    }
+    ~Scope() { exit(); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    void enter(const void *id, const char *kind, const std::string& name, const Location& loc, EvaluationSession *session) {
+      if (EvaluationProfiler *profiler = instance()) {
+        exit();
+        entered = profiler->enter(id, kind, name, loc, session);
+      }
+    }
+    void exit() {
+      if (entered) {
+        active->exit();
+        entered = false;
+      }
+    }
+private:
+    bool entered = false;
+  };
+
+  void writeJson(std::ostream& stream, const std::string& docPath) const;
+  void writeFolded(std::ostream& stream) const;
+
+private:
+  struct Definition {
+    const char *kind;
+    std::string name;
+    Location loc;
+    size_t calls = 0;
+    clock::duration inclusive{};
+    clock::duration exclusive{};
+    size_t values = 0;
+    size_t active = 0; // open calls, to count recursive time only once
+  };
+  struct Node {
+    Definition *definition;
+    Node *parent;
+    clock::duration exclusive{};
+    std::unordered_map<const Definition *, std::unique_ptr<Node>> children;
+  };
+  struct Frame {
+    Node *node;
+    EvaluationSession *session;
+    clock::time_point start;
+    clock::duration callees{};
+    size_t values_start;
+    size_t callee_values = 0;
+  };
+
+  EvaluationProfiler();
+  static EvaluationProfiler& profiler();
+  bool enter(const void *id, const char *kind, const std::string& name, const Location& loc, EvaluationSession *session);
+  void exit();
+  void writeFolded(std::ostream& stream, const Node& node, const std::string& prefix) const;
+
+  static EvaluationProfiler *active;
+
+  std::unordered_map<const void *, Definition> definitions;
+  Node root;
+  std::vector<Frame> stack;
+};
@@ -28,8 +28,66 @@
 #include "EvaluationSession.h"
 #include "printutils.h"
 
+#include <atomic>
+
+namespace {
+thread_local EvaluationSession *active_fork = nullptr;
+std::atomic<uint64_t> next_owner{1};
+}
+
+EvaluationSession::EvaluationSession(EvaluationSession *parent) :
+  document_root(parent->document_root),
+  stack(parent->stack),
+  parent(parent),
+  owner(next_owner++),
+  context_memory_manager(parent->accounting())
+{}
+
+std::unique_ptr<EvaluationSession> EvaluationSession::fork()
+{
+  assert(!parent);
+  return std::unique_ptr<EvaluationSession>(new EvaluationSession(this));
+}
+
+void EvaluationSession::join(EvaluationSession& fork)
+{
+  assert(fork.parent == this);
+  context_memory_manager.adopt(fork.context_memory_manager);
+}
+
+EvaluationSession::ForkScope::ForkScope(EvaluationSession *fork) : previous(active_fork)
+{
+  active_fork = fork;
+}
+
+EvaluationSession::ForkScope::~ForkScope()
+{
+  active_fork = previous;
+}
+
+uint64_t EvaluationSession::threadOwner()
+{
+  return active_fork ? active_fork->owner : 0;
+}
+
+bool EvaluationSession::isThreadOwned(uint64_t owner)
+{
+  return !active_fork || owner == active_fork->owner;
+}
+
+EvaluationSession& EvaluationSession::local()
+{
+  return active_fork && active_fork->parent == this ? *active_fork : *this;
+}
+
+const EvaluationSession& EvaluationSession::local() const
+{
+  return active_fork && active_fork->parent == this ? *active_fork : *this;
+}
+
 size_t EvaluationSession::push_frame(ContextFrame *frame)
 {
+  auto& stack = local().stack;
   size_t index = stack.size();
   stack.push_back(frame);
   return index;
@@ -37,18 +95,21 @@ size_t EvaluationSession::push_frame(ContextFrame *frame)
 
 void EvaluationSession::replace_frame(size_t index, ContextFrame *frame)
 {
+  auto& stack = local().stack;
   assert(index < stack.size());
   stack[index] = frame;
 }
 
 void EvaluationSession::pop_frame(size_t index)
 {
+  auto& stack = local().stack;
   stack.pop_back();
   assert(stack.size() == index);
 }
 
 boost::optional<const Value&> EvaluationSession::try_lookup_special_variable(const std::string& name) const
 {
+  const auto& stack = local().stack;
   for (auto it = stack.crbegin(); it != stack.crend(); ++it) {
     boost::optional<const Value&> result = (*it)->lookup_local_variable(name);
     if (result) {
@@ -70,6 +131,7 @@ const Value& EvaluationSession::lookup_special_variable(const std::string& name,
 
 boost::optional<CallableFunction> EvaluationSession::lookup_special_function(const std::string& name, const Location& loc) const
 {
+  const auto& stack = local().stack;
   for (auto it = stack.crbegin(); it != stack.crend(); ++it) {
     boost::optional<CallableFunction> result = (*it)->lookup_local_function(name, loc);
     if (result) {
@@ -82,6 +144,7 @@ boost::optional<CallableFunction> EvaluationSession::lookup_special_function(con
 
 boost::optional<InstantiableModule> EvaluationSession::lookup_special_module(const std::string& name, const Location& loc) const
 {
+  const auto& stack = local().stack;
   for (auto it = stack.crbegin(); it != stack.crend(); ++it) {
     boost::optional<InstantiableModule> result = (*it)->lookup_local_module(name, loc);
     if (result) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,11 +31,51 @@ public:
   [[nodiscard]] boost::optional<InstantiableModule> lookup_special_module(const std::string& name, const Location& loc) const;
 
   [[nodiscard]] const std::string& documentRoot() const { return document_root; }
-  ContextMemoryManager& contextMemoryManager() { return context_memory_manager; }
+  ContextMemoryManager& contextMemoryManager() { return local().context_memory_manager; }
   HeapSizeAccounting& accounting() { return context_memory_manager.accounting(); }
 
+  /*
+   * A fork is a session for one worker thread evaluating on behalf of this
+   * session. It starts out with a copy of the special variable stack, so the
+   * worker sees the same $variables, but keeps its own stack and records its
+   * own contexts, so that worker threads don't touch each other's state.
+   *
+   * Contexts and values created by the worker still refer to this session,
+   * and count towards its heap size. Calls on this session from a thread in
+   * a ForkScope are routed to the fork. A fork can thus be destroyed as soon
+   * as it has been joined.
+   */
+  std::unique_ptr<EvaluationSession> fork();
+  // Hands the contexts created in a finished fork over to this session.
+  void join(EvaluationSession& fork);
+
+  // Makes calls on the parent of fork from this thread use fork while it exists.
+  class ForkScope
+  {
+public:
+    ForkScope(EvaluationSession *fork);
+    ~ForkScope();
+    ForkScope(const ForkScope&) = delete;
+    ForkScope& operator=(const ForkScope&) = delete;
+private:
+    EvaluationSession *previous;
+  };
+
+  // Identifies the values created on this thread: 0 outside of worker
+  // threads, otherwise a number unique to the fork the thread evaluates in.
+  static uint64_t threadOwner();
+  // Whether values created by owner may be modified in place on this thread.
+  static bool isThreadOwned(uint64_t owner);
+
 private:
+  EvaluationSession(EvaluationSession *parent);
+  // The fork of this session active on this thread, or this session.
+  EvaluationSession& local();
+  const EvaluationSession& local() const;
+
   std::string document_root;
   std::vector<ContextFrame *> stack;
+  EvaluationSession *parent = nullptr;
+  uint64_t owner = 0;
   ContextMemoryManager context_memory_manager;
 };
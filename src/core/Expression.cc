@@ -36,6 +36,7 @@
 #include <forward_list>
 #include <utility>
 #include <variant>
+#include <exception>
 #include "printutils.h"
 #include "StackCheck.h"
 #include "Context.h"
@@ -43,6 +44,11 @@
 #include "Parameters.h"
 #include "printutils.h"
 #include "boost-utils.h"
+#include "Feature.h"
+#include "PurityCheck.h"
+#include "EvaluationSession.h"
+#include "EvaluationProfiler.h"
+#include "parallel.h"
 #include <boost/regex.hpp>
 #include <boost/assign/std/vector.hpp>
 using namespace boost::assign; // bring 'operator+=()' into scope
@@ -57,6 +63,11 @@ bool Expression::isLiteral() const
   return false;
 }
 
+bool Expression::isPure(PurityCheck& /*check*/) const
+{
+  return false;
+}
+
 UnaryOp::UnaryOp(UnaryOp::Op op, Expression *expr, const Location& loc) : Expression(loc), op(op), expr(expr)
 {
 }
@@ -87,6 +98,11 @@ bool UnaryOp::isLiteral() const {
   return this->expr->isLiteral();
 }
 
+bool UnaryOp::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->expr.get());
+}
+
 void UnaryOp::print(std::ostream& stream, const std::string&) const
 {
   stream << opString() << *this->expr;
@@ -157,6 +173,11 @@ const char *BinaryOp::opString() const
   }
 }
 
+bool BinaryOp::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->left.get()) && check.isPure(this->right.get());
+}
+
 void BinaryOp::print(std::ostream& stream, const std::string&) const
 {
   stream << "(" << *this->left << " " << opString() << " " << *this->right << ")";
@@ -177,6 +198,11 @@ Value TernaryOp::evaluate(const std::shared_ptr<const Context>& context) const
   return evaluateStep(context)->evaluate(context);
 }
 
+bool TernaryOp::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->cond.get()) && check.isPure(this->ifexpr.get()) && check.isPure(this->elseexpr.get());
+}
+
 void TernaryOp::print(std::ostream& stream, const std::string&) const
 {
   stream << "(" << *this->cond << " ? " << *this->ifexpr << " : " << *this->elseexpr << ")";
@@ -191,6 +217,11 @@ Value ArrayLookup::evaluate(const std::shared_ptr<const Context>& context) const
   return this->array->evaluate(context)[this->index->evaluate(context)];
 }
 
+bool ArrayLookup::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->array.get()) && check.isPure(this->index.get());
+}
+
 void ArrayLookup::print(std::ostream& stream, const std::string&) const
 {
   stream << *array << "[" << *index << "]";
@@ -201,6 +232,11 @@ Value Literal::evaluate(const std::shared_ptr<const Context>&) const
   return value.clone();
 }
 
+bool Literal::isPure(PurityCheck& check) const
+{
+  return true;
+}
+
 void Literal::print(std::ostream& stream, const std::string&) const
 {
   stream << value;
@@ -266,6 +302,11 @@ Value Range::evaluate(const std::shared_ptr<const Context>& context) const
   return Value::undefined.clone();
 }
 
+bool Range::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->begin.get()) && check.isPure(this->step.get()) && check.isPure(this->end.get());
+}
+
 void Range::print(std::ostream& stream, const std::string&) const
 {
   stream << "[" << *this->begin;
@@ -299,6 +340,13 @@ bool Vector::isLiteral() const {
   }
 }
 
+bool Vector::isComprehension() const
+{
+  return std::any_of(this->children.begin(), this->children.end(), [](const shared_ptr<Expression>& e) {
+    return dynamic_cast<const ListComprehension *>(e.get()) != nullptr;
+  });
+}
+
 void Vector::emplace_back(Expression *expr)
 {
   this->children.emplace_back(expr);
@@ -323,6 +371,18 @@ Value Vector::evaluate(const std::shared_ptr<const Context>& context) const
   }
 }
 
+void Vector::generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const
+{
+  for (const auto& e : this->children) ListComprehension::generateElement(e.get(), context, yield);
+}
+
+bool Vector::isPure(PurityCheck& check) const
+{
+  return std::all_of(this->children.begin(), this->children.end(), [&check](const auto& child) {
+    return check.isPure(child.get());
+  });
+}
+
 void Vector::print(std::ostream& stream, const std::string&) const
 {
   stream << "[";
@@ -342,6 +402,11 @@ Value Lookup::evaluate(const std::shared_ptr<const Context>& context) const
   return context->lookup_variable(this->name, loc).clone();
 }
 
+bool Lookup::isPure(PurityCheck& check) const
+{
+  return check.isPureVariable(this->name);
+}
+
 void Lookup::print(std::ostream& stream, const std::string&) const
 {
   stream << this->name;
@@ -392,6 +457,11 @@ Value MemberLookup::evaluate(const std::shared_ptr<const Context>& context) cons
   return Value::undefined.clone();
 }
 
+bool MemberLookup::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->expr.get());
+}
+
 void MemberLookup::print(std::ostream& stream, const std::string&) const
 {
   stream << *this->expr << "." << this->member;
@@ -407,6 +477,12 @@ Value FunctionDefinition::evaluate(const std::shared_ptr<const Context>& context
   return FunctionPtr{FunctionType{context, expr, std::make_unique<AssignmentList>(parameters)}};
 }
 
+bool FunctionDefinition::isPure(PurityCheck& check) const
+{
+  // The body only runs once the function is called, which is checked at the call site.
+  return check.isPure(this->parameters);
+}
+
 void FunctionDefinition::print(std::ostream& stream, const std::string& indent) const
 {
   stream << indent << "function(";
@@ -515,7 +591,9 @@ static SimplificationResult simplify_function_body(const Expression *expression,
       } else {
         auto index = f->index();
         if (index == 0) {
-          return std::get<const BuiltinFunction *>(*f)->evaluate(context, call);
+          const auto *builtin = std::get<const BuiltinFunction *>(*f);
+          EvaluationProfiler::Scope profile(builtin, "builtin function", call->get_name(), Location::NONE, context->session());
+          return builtin->evaluate(context, call);
         } else if (index == 1) {
           CallableUserFunction callable = std::get<CallableUserFunction>(*f);
           function_body = callable.function->expr.get();
@@ -565,6 +643,7 @@ Value FunctionCall::evaluate(const std::shared_ptr<const Context>& context) cons
 
   ContextHandle<Context> expression_context{Context::create<Context>(context)};
   const Expression *expression = this;
+  EvaluationProfiler::Scope profile; // tail calls replace the profiled call
   while (true) {
     try {
       auto result = simplify_function_body(expression, *expression_context);
@@ -581,6 +660,7 @@ Value FunctionCall::evaluate(const std::shared_ptr<const Context>& context) cons
       }
       if (simplified_expression->new_active_function_call) {
         current_call = *simplified_expression->new_active_function_call;
+        profile.enter(expression, "function", current_call->get_name(), expression->location(), expression_context->session());
         if (recursion_depth++ == 1000000) {
           LOG(message_group::Error, expression->location(), expression_context->documentRoot(), "Recursion detected calling function '%1$s'", current_call->name);
           throw RecursionException::create("function", current_call->name, current_call->location());
@@ -596,6 +676,11 @@ Value FunctionCall::evaluate(const std::shared_ptr<const Context>& context) cons
   }
 }
 
+bool FunctionCall::isPure(PurityCheck& check) const
+{
+  return check.isPureCall(*this);
+}
+
 void FunctionCall::print(std::ostream& stream, const std::string&) const
 {
   stream << this->get_name() << "(" << this->arguments << ")";
@@ -723,6 +808,12 @@ Value Let::evaluate(const std::shared_ptr<const Context>& context) const
   return evaluateStep(letContext)->evaluate(*letContext);
 }
 
+bool Let::isPure(PurityCheck& check) const
+{
+  PurityCheck::Scope scope(check);
+  return check.bindSequentially(this->arguments) && check.isPure(this->expr.get());
+}
+
 void Let::print(std::ostream& stream, const std::string&) const
 {
   stream << "let(" << this->arguments << ") " << *expr;
@@ -732,6 +823,32 @@ ListComprehension::ListComprehension(const Location& loc) : Expression(loc)
 {
 }
 
+bool ListComprehension::lazyEvaluation()
+{
+  return Feature::ExperimentalLazyComprehensions.is_enabled();
+}
+
+bool ListComprehension::parallelEvaluation()
+{
+  return Feature::ExperimentalParallelComprehensions.is_enabled() && !Parallel::isWorker() && Parallel::concurrency() > 1;
+}
+
+// Produce the element(s) expr contributes to an enclosing vector.
+// Nested comprehensions are streamed, anything else is a single element.
+void ListComprehension::generateElement(const Expression *expr, const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield)
+{
+  if (const auto *lc = dynamic_cast<const ListComprehension *>(expr)) {
+    lc->generate(context, yield);
+    return;
+  }
+  Value value = expr->evaluate(context);
+  if (value.type() == Value::Type::EMBEDDED_VECTOR) {
+    for (const auto& element : value.toEmbeddedVector()) yield(element.clone());
+  } else {
+    yield(std::move(value));
+  }
+}
+
 LcIf::LcIf(Expression *cond, Expression *ifexpr, Expression *elseexpr, const Location& loc)
   : ListComprehension(loc), cond(cond), ifexpr(ifexpr), elseexpr(elseexpr)
 {
@@ -747,6 +864,17 @@ Value LcIf::evaluate(const std::shared_ptr<const Context>& context) const
   }
 }
 
+void LcIf::generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const
+{
+  const shared_ptr<Expression>& expr = this->cond->evaluate(context).toBool() ? this->ifexpr : this->elseexpr;
+  if (expr) generateElement(expr.get(), context, yield);
+}
+
+bool LcIf::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->cond.get()) && check.isPure(this->ifexpr.get()) && check.isPure(this->elseexpr.get());
+}
+
 void LcIf::print(std::ostream& stream, const std::string&) const
 {
   stream << "if(" << *this->cond << ") (" << *this->ifexpr << ")";
@@ -798,6 +926,44 @@ Value LcEach::evaluate(const std::shared_ptr<const Context>& context) const
   return evalRecur(this->expr->evaluate(context), context);
 }
 
+// Streaming equivalent of evalRecur
+void LcEach::generateRecur(Value&& v, const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const
+{
+  if (v.type() == Value::Type::RANGE) {
+    const RangeType& range = v.toRange();
+    uint32_t steps = range.numValues();
+    if (steps >= 1000000) {
+      LOG(message_group::Warning, loc, context->documentRoot(), "Bad range parameter in for statement: too many elements (%1$lu)", steps);
+    } else {
+      for (double d : range) yield(d);
+    }
+  } else if (v.type() == Value::Type::VECTOR) {
+    for (const auto& val : v.toVector()) yield(val.clone());
+  } else if (v.type() == Value::Type::EMBEDDED_VECTOR) {
+    for (const auto& val : v.toEmbeddedVector()) generateRecur(val.clone(), context, yield);
+  } else if (v.type() == Value::Type::STRING) {
+    for (auto ch : v.toStrUtf8Wrapper()) yield(Value(std::move(ch)));
+  } else if (v.type() != Value::Type::UNDEFINED) {
+    yield(std::move(v));
+  }
+}
+
+void LcEach::generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const
+{
+  // each [for (...) ...] passes the generated elements straight through
+  const auto *vector = dynamic_cast<const Vector *>(this->expr.get());
+  if (vector && vector->isComprehension()) {
+    vector->generate(context, yield);
+  } else {
+    generateRecur(this->expr->evaluate(context), context, yield);
+  }
+}
+
+bool LcEach::isPure(PurityCheck& check) const
+{
+  return check.isPure(this->expr.get());
+}
+
 void LcEach::print(std::ostream& stream, const std::string&) const
 {
   stream << "each (" << *this->expr << ")";
@@ -815,6 +981,15 @@ static inline ContextHandle<Context> forContext(const std::shared_ptr<const Cont
   return innerContext;
 }
 
+static void doForEachValue(
+  const AssignmentList& assignments,
+  const Location& location,
+  const std::function<void(const std::shared_ptr<const Context>&)>& operation,
+  size_t assignment_index,
+  const std::shared_ptr<const Context>& context,
+  Value variable_values
+  );
+
 static void doForEach(
   const AssignmentList& assignments,
   const Location& location,
@@ -828,7 +1003,33 @@ static void doForEach(
   }
 
   const std::string& variable_name = assignments[assignment_index]->getName();
-  Value variable_values = assignments[assignment_index]->getExpr()->evaluate(context);
+  const Expression *variable_expr = assignments[assignment_index]->getExpr().get();
+
+  // Iterate directly over the elements of a list comprehension, instead of building the full list first
+  if (ListComprehension::lazyEvaluation()) {
+    const auto *vector = dynamic_cast<const Vector *>(variable_expr);
+    if (vector && vector->isComprehension()) {
+      vector->generate(context, [&](Value&& value) {
+        doForEach(assignments, location, operation, assignment_index + 1,
+                  *forContext(context, variable_name, std::move(value))
+                  );
+      });
+      return;
+    }
+  }
+
+  doForEachValue(assignments, location, operation, assignment_index, context, variable_expr->evaluate(context));
+}
+
+static void doForEachValue(
+  const AssignmentList& assignments,
+  const Location& location,
+  const std::function<void(const std::shared_ptr<const Context>&)>& operation,
+  size_t assignment_index,
+  const std::shared_ptr<const Context>& context,
+  Value variable_values
+  ) {
+  const std::string& variable_name = assignments[assignment_index]->getName();
 
   if (variable_values.type() == Value::Type::RANGE) {
     const RangeType& range = variable_values.toRange();
@@ -875,6 +1076,10 @@ void LcFor::forEach(const AssignmentList& assignments, const Location& loc, cons
 
 Value LcFor::evaluate(const std::shared_ptr<const Context>& context) const
 {
+  if (parallelEvaluation() && !this->arguments.empty()) {
+    return evaluateParallel(context);
+  }
+
   EmbeddedVectorType vec(context->session());
   forEach(this->arguments, this->loc, context,
           [&vec, expression = expr.get()] (const std::shared_ptr<const Context>& iterationContext) {
@@ -884,6 +1089,107 @@ Value LcFor::evaluate(const std::shared_ptr<const Context>& context) const
   return {std::move(vec)};
 }
 
+/*
+ * Splits the values of the first loop variable into one chunk per thread,
+ * provided there are enough of them and the rest of the loop is pure.
+ * Messages logged by the workers are printed once all of them are done, in
+ * iteration order, followed by the first error thrown, if any.
+ */
+Value LcFor::evaluateParallel(const std::shared_ptr<const Context>& context) const
+{
+  EmbeddedVectorType vec(context->session());
+  const std::string& variable_name = this->arguments.front()->getName();
+  Value variable_values = this->arguments.front()->getExpr()->evaluate(context);
+
+  std::vector<Value> elements;
+  if (variable_values.type() == Value::Type::RANGE) {
+    const RangeType& range = variable_values.toRange();
+    const uint32_t steps = range.numValues();
+    if (steps >= MIN_PARALLEL_ITERATIONS && steps < 1000000) {
+      elements.reserve(steps);
+      for (double value : range) elements.emplace_back(value);
+    }
+  } else if (variable_values.type() == Value::Type::VECTOR) {
+    const VectorType& values = variable_values.toVector();
+    if (values.size() >= MIN_PARALLEL_ITERATIONS) {
+      elements.reserve(values.size());
+      for (const auto& value : values) elements.push_back(value.clone());
+    }
+  }
+
+  bool pure = !elements.empty();
+  if (pure) {
+    PurityCheck check(context);
+    check.bind(variable_name);
+    for (size_t i = 1; pure && i < this->arguments.size(); ++i) {
+      pure = check.isPure(this->arguments[i]->getExpr().get());
+      check.bind(this->arguments[i]->getName());
+    }
+    pure = pure && check.isPure(expr.get());
+  }
+  if (!pure) {
+    doForEachValue(this->arguments, this->loc,
+                   [&vec, expression = expr.get()] (const std::shared_ptr<const Context>& iterationContext) {
+      vec.emplace_back(expression->evaluate(iterationContext));
+    }, 0, context, std::move(variable_values));
+    return {std::move(vec)};
+  }
+
+  struct Chunk {
+    std::unique_ptr<EvaluationSession> session;
+    std::vector<Value> values;
+    std::vector<Message> messages;
+    std::exception_ptr error;
+  };
+  EvaluationSession *session = context->session();
+  std::vector<Chunk> chunks(std::min<size_t>(Parallel::concurrency(), elements.size()));
+  for (auto& chunk : chunks) chunk.session = session->fork();
+
+  Parallel::run(chunks.size(), [&](size_t index) {
+    Chunk& chunk = chunks[index];
+    EvaluationSession::ForkScope fork(chunk.session.get());
+    MessageCapture capture(chunk.messages);
+    try {
+      const size_t begin = index * elements.size() / chunks.size();
+      const size_t end = (index + 1) * elements.size() / chunks.size();
+      for (size_t i = begin; i < end; ++i) {
+        doForEach(this->arguments, this->loc,
+                  [&chunk, expression = expr.get()] (const std::shared_ptr<const Context>& iterationContext) {
+          chunk.values.push_back(expression->evaluate(iterationContext));
+        }, 1, *forContext(context, variable_name, std::move(elements[i])));
+      }
+    } catch (...) {
+      chunk.error = std::current_exception();
+    }
+  });
+
+  for (auto& chunk : chunks) {
+    session->join(*chunk.session);
+    chunk.session.reset();
+  }
+  for (auto& chunk : chunks) {
+    print_captured_messages(chunk.messages);
+    if (chunk.error) std::rethrow_exception(chunk.error);
+    for (auto& value : chunk.values) vec.emplace_back(std::move(value));
+  }
+  return {std::move(vec)};
+}
+
+void LcFor::generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const
+{
+  forEach(this->arguments, this->loc, context,
+          [&yield, expression = expr.get()] (const std::shared_ptr<const Context>& iterationContext) {
+    generateElement(expression, iterationContext, yield);
+  }
+          );
+}
+
+bool LcFor::isPure(PurityCheck& check) const
+{
+  PurityCheck::Scope scope(check);
+  return check.bindSequentially(this->arguments) && check.isPure(this->expr.get());
+}
+
 void LcFor::print(std::ostream& stream, const std::string&) const
 {
   stream << "for(" << this->arguments << ") (" << *this->expr << ")";
@@ -894,16 +1200,14 @@ LcForC::LcForC(AssignmentList args, AssignmentList incrargs, Expression *cond, E
 {
 }
 
-Value LcForC::evaluate(const std::shared_ptr<const Context>& context) const
+void LcForC::forEach(const std::shared_ptr<const Context>& context, const std::function<void(const std::shared_ptr<const Context>&)>& operation) const
 {
-  EmbeddedVectorType output(context->session());
-
   ContextHandle<Context> initialContext{Let::sequentialAssignmentContext(this->arguments, this->location(), context)};
   ContextHandle<Context> currentContext{Context::create<Context>(*initialContext)};
 
   unsigned int counter = 0;
   while (this->cond->evaluate(*currentContext).toBool()) {
-    output.emplace_back(this->expr->evaluate(*currentContext));
+    operation(*currentContext);
 
     if (counter++ == 1000000) {
       LOG(message_group::Error, loc, context->documentRoot(), "For loop counter exceeded limit");
@@ -925,9 +1229,31 @@ Value LcForC::evaluate(const std::shared_ptr<const Context>& context) const
     currentContext = std::move(nextContext);
     currentContext->setParent(*initialContext);
   }
+}
+
+Value LcForC::evaluate(const std::shared_ptr<const Context>& context) const
+{
+  EmbeddedVectorType output(context->session());
+  forEach(context, [&output, expression = expr.get()] (const std::shared_ptr<const Context>& iterationContext) {
+    output.emplace_back(expression->evaluate(iterationContext));
+  });
   return {std::move(output)};
 }
 
+void LcForC::generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const
+{
+  forEach(context, [&yield, expression = expr.get()] (const std::shared_ptr<const Context>& iterationContext) {
+    generateElement(expression, iterationContext, yield);
+  });
+}
+
+bool LcForC::isPure(PurityCheck& check) const
+{
+  PurityCheck::Scope scope(check);
+  return check.bindSequentially(this->arguments) && check.isPure(this->cond.get()) &&
+         check.bindSequentially(this->incr_arguments) && check.isPure(this->expr.get());
+}
+
 void LcForC::print(std::ostream& stream, const std::string&) const
 {
   stream
@@ -947,6 +1273,17 @@ Value LcLet::evaluate(const std::shared_ptr<const Context>& context) const
   return this->expr->evaluate(*Let::sequentialAssignmentContext(this->arguments, this->location(), context));
 }
 
+void LcLet::generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const
+{
+  generateElement(this->expr.get(), *Let::sequentialAssignmentContext(this->arguments, this->location(), context), yield);
+}
+
+bool LcLet::isPure(PurityCheck& check) const
+{
+  PurityCheck::Scope scope(check);
+  return check.bindSequentially(this->arguments) && check.isPure(this->expr.get());
+}
+
 void LcLet::print(std::ostream& stream, const std::string&) const
 {
   stream << "let(" << this->arguments << ") (" << *this->expr << ")";
@@ -11,6 +11,7 @@
 #include "Value.h"
 
 template <class T> class ContextHandle;
+class PurityCheck;
 
 class Expression : public ASTNode
 {
@@ -18,6 +19,8 @@ public:
   Expression(const Location& loc) : ASTNode(loc) {}
   [[nodiscard]] virtual bool isLiteral() const;
   [[nodiscard]] virtual Value evaluate(const std::shared_ptr<const Context>& context) const = 0;
+  // Whether this can be evaluated on a worker thread, see PurityCheck. False unless overridden.
+  [[nodiscard]] virtual bool isPure(PurityCheck& check) const;
   Value checkUndef(Value&& val, const std::shared_ptr<const Context>& context) const;
 };
 
@@ -31,6 +34,7 @@ public:
   [[nodiscard]] bool isLiteral() const override;
   UnaryOp(Op op, Expression *expr, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 
 private:
@@ -62,6 +66,7 @@ public:
 
   BinaryOp(Expression *left, Op op, Expression *right, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 
 private:
@@ -78,6 +83,7 @@ public:
   TernaryOp(Expression *cond, Expression *ifexpr, Expression *elseexpr, const Location& loc);
   [[nodiscard]] const Expression *evaluateStep(const std::shared_ptr<const Context>& context) const;
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
   shared_ptr<Expression> cond;
@@ -90,6 +96,7 @@ class ArrayLookup : public Expression
 public:
   ArrayLookup(Expression *array, Expression *index, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
   shared_ptr<Expression> array;
@@ -110,6 +117,7 @@ public:
   [[nodiscard]] bool isUndefined() const { return value.type() == Value::Type::UNDEFINED; }
 
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
   [[nodiscard]] bool isLiteral() const override { return true; }
 private:
@@ -125,6 +133,7 @@ public:
   [[nodiscard]] const Expression *getStep() const { return step.get(); }
   [[nodiscard]] const Expression *getEnd() const { return end.get(); }
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
   [[nodiscard]] bool isLiteral() const override;
 private:
@@ -139,9 +148,13 @@ public:
   Vector(const Location& loc);
   const std::vector<shared_ptr<Expression>>& getChildren() const { return children; }
   Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
+  // Streams the elements of this vector to yield, without materializing a VectorType.
+  void generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const;
   void print(std::ostream& stream, const std::string& indent) const override;
   void emplace_back(Expression *expr);
   bool isLiteral() const override;
+  bool isComprehension() const;
 private:
   std::vector<shared_ptr<Expression>> children;
   mutable boost::tribool literal_flag; // cache if already computed
@@ -152,6 +165,7 @@ class Lookup : public Expression
 public:
   Lookup(std::string name, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
   [[nodiscard]] const std::string& get_name() const { return name; }
 private:
@@ -163,6 +177,7 @@ class MemberLookup : public Expression
 public:
   MemberLookup(Expression *expr, std::string member, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
   shared_ptr<Expression> expr;
@@ -175,6 +190,7 @@ public:
   FunctionCall(Expression *expr, AssignmentList arglist, const Location& loc);
   [[nodiscard]] boost::optional<CallableFunction> evaluate_function_expression(const std::shared_ptr<const Context>& context) const;
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
   [[nodiscard]] const std::string& get_name() const { return name; }
   static Expression *create(const std::string& funcname, const AssignmentList& arglist, Expression *expr, const Location& loc);
@@ -190,6 +206,7 @@ class FunctionDefinition : public Expression
 public:
   FunctionDefinition(Expression *expr, AssignmentList parameters, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 public:
   shared_ptr<const Context> context;
@@ -230,6 +247,7 @@ public:
   static ContextHandle<Context> sequentialAssignmentContext(const AssignmentList& assignments, const Location& location, const std::shared_ptr<const Context>& context);
   const Expression *evaluateStep(ContextHandle<Context>& targetContext) const;
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
   AssignmentList arguments;
@@ -240,6 +258,12 @@ class ListComprehension : public Expression
 {
 public:
   ListComprehension(const Location& loc);
+  // Lazy counterpart of evaluate(): passes each produced element to yield, in order,
+  // instead of collecting them into an EmbeddedVectorType.
+  virtual void generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const = 0;
+  static void generateElement(const Expression *expr, const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield);
+  static bool lazyEvaluation();
+  static bool parallelEvaluation();
 };
 
 class LcIf : public ListComprehension
@@ -247,6 +271,8 @@ class LcIf : public ListComprehension
 public:
   LcIf(Expression *cond, Expression *ifexpr, Expression *elseexpr, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
+  void generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
   shared_ptr<Expression> cond;
@@ -260,8 +286,13 @@ public:
   LcFor(AssignmentList args, Expression *expr, const Location& loc);
   static void forEach(const AssignmentList& assignments, const Location& loc, const std::shared_ptr<const Context>& context, const std::function<void(const std::shared_ptr<const Context>&)>& operation);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
+  void generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
+  // Smaller loops are not worth starting threads for
+  static constexpr size_t MIN_PARALLEL_ITERATIONS = 64;
+  [[nodiscard]] Value evaluateParallel(const std::shared_ptr<const Context>& context) const;
   AssignmentList arguments;
   shared_ptr<Expression> expr;
 };
@@ -271,8 +302,11 @@ class LcForC : public ListComprehension
 public:
   LcForC(AssignmentList args, AssignmentList incrargs, Expression *cond, Expression *expr, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
+  void generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
+  void forEach(const std::shared_ptr<const Context>& context, const std::function<void(const std::shared_ptr<const Context>&)>& operation) const;
   AssignmentList arguments;
   AssignmentList incr_arguments;
   shared_ptr<Expression> cond;
@@ -284,9 +318,12 @@ class LcEach : public ListComprehension
 public:
   LcEach(Expression *expr, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
+  void generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
   Value evalRecur(Value&& v, const std::shared_ptr<const Context>& context) const;
+  void generateRecur(Value&& v, const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const;
   shared_ptr<Expression> expr;
 };
 
@@ -295,6 +332,8 @@ class LcLet : public ListComprehension
 public:
   LcLet(AssignmentList args, Expression *expr, const Location& loc);
   [[nodiscard]] Value evaluate(const std::shared_ptr<const Context>& context) const override;
+  [[nodiscard]] bool isPure(PurityCheck& check) const override;
+  void generate(const std::shared_ptr<const Context>& context, const std::function<void(Value&&)>& yield) const override;
   void print(std::ostream& stream, const std::string& indent) const override;
 private:
   AssignmentList arguments;
@@ -4,6 +4,8 @@
 #include "Expression.h"
 #include "exceptions.h"
 #include "printutils.h"
+#include "EvaluationProfiler.h"
+#include "UserModule.h"
 
 void ModuleInstantiation::print(std::ostream& stream, const std::string& indent, const bool inlined) const
 {
@@ -65,6 +67,13 @@ std::shared_ptr<AbstractNode> ModuleInstantiation::evaluate(const std::shared_pt
     return nullptr;
   }
 
+  EvaluationProfiler::Scope profile;
+  if (EvaluationProfiler::instance()) {
+    const auto *user_module = dynamic_cast<const UserModule *>(module->module);
+    profile.enter(module->module, user_module ? "module" : "builtin module", this->name(),
+                  user_module ? user_module->location() : Location::NONE, context->session());
+  }
+
   try{
     auto node = module->module->instantiate(module->defining_context, this, context);
     return node;
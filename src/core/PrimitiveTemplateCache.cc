@@ -0,0 +1,55 @@
+#include "PrimitiveTemplateCache.h"
+#include "printutils.h"
+
+PrimitiveTemplateCache *PrimitiveTemplateCache::inst = nullptr;
+
+std::shared_ptr<const void> PrimitiveTemplateCache::get(const std::string& id) const
+{
+  const auto *entry = this->cache[id];
+  return entry ? entry->tmpl : nullptr;
+}
+
+bool PrimitiveTemplateCache::insert(const std::string& id, const std::shared_ptr<const void>& tmpl, size_t cost)
+{
+  return this->cache.insert(id, new cache_entry(tmpl), id.size() + cost);
+}
+
+size_t PrimitiveTemplateCache::size() const
+{
+  return cache.size();
+}
+
+size_t PrimitiveTemplateCache::totalCost() const
+{
+  return cache.totalCost();
+}
+
+std::map<std::string, CacheUsage> PrimitiveTemplateCache::usageByKind() const
+{
+  std::map<std::string, CacheUsage> usage;
+  this->cache.forEach([&](const std::string& id, const cache_entry& /*entry*/, size_t cost) {
+    auto& kind = usage[id.substr(0, id.find(' '))];
+    kind.entries++;
+    kind.cost += cost;
+  });
+  return usage;
+}
+
+size_t PrimitiveTemplateCache::maxSizeMB() const
+{
+  return this->cache.maxCost() / (1024ul * 1024ul);
+}
+
+void PrimitiveTemplateCache::setMaxSizeMB(size_t limit)
+{
+  this->cache.setMaxCost(limit * 1024ul * 1024ul);
+}
+
+void PrimitiveTemplateCache::print()
+{
+  LOG(message_group::None, Location::NONE, "", "Primitive templates in cache: %1$d", this->cache.size());
+  LOG(message_group::None, Location::NONE, "", "Primitive template cache size in bytes: %1$d", this->cache.totalCost());
+  for (const auto& [kind, usage] : usageByKind()) {
+    LOG(message_group::None, Location::NONE, "", "   %1$s: %2$d entries, %3$d bytes", kind, usage.entries, usage.cost);
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Cache.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+/*!
+   Caches the unit size tessellations of sphere(), cylinder() and circle(),
+   keyed by primitive kind and tessellation parameters. Entries are opaque to
+   the cache and owned by primitives.cc.
+ */
+class PrimitiveTemplateCache
+{
+public:
+  PrimitiveTemplateCache(size_t memorylimit = 16ul * 1024ul * 1024ul) : cache(memorylimit) {}
+
+  static PrimitiveTemplateCache *instance() { if (!inst) inst = new PrimitiveTemplateCache; return inst; }
+
+  std::shared_ptr<const void> get(const std::string& id) const;
+  bool insert(const std::string& id, const std::shared_ptr<const void>& tmpl, size_t cost);
+  size_t size() const;
+  size_t totalCost() const;
+  // Entries and their cost by primitive, the first word of their id
+  std::map<std::string, CacheUsage> usageByKind() const;
+  size_t maxSizeMB() const;
+  void setMaxSizeMB(size_t limit);
+  void clear() { cache.clear(); }
+  void print();
+
+private:
+  static PrimitiveTemplateCache *inst;
+
+  struct cache_entry {
+    std::shared_ptr<const void> tmpl;
+    cache_entry(const std::shared_ptr<const void>& tmpl) : tmpl(tmpl) {}
+  };
+
+  Cache<std::string, cache_entry> cache;
+};
@@ -0,0 +1,107 @@
+#include "PurityCheck.h"
+
+#include <algorithm>
+
+#include "Context.h"
+#include "Expression.h"
+#include "function.h"
+#include "printutils.h"
+
+namespace {
+
+// Builtins with side effects, or reading state outside of the evaluation.
+bool isImpureBuiltin(const FunctionCall& call)
+{
+  const auto& name = call.get_name();
+  if (name == "rands") return call.arguments.size() < 4; // unseeded
+  return name == "dxf_dim" || name == "dxf_cross" || name == "import" ||
+         name == "textmetrics" || name == "fontmetrics";
+}
+
+} // namespace
+
+PurityCheck::PurityCheck(std::shared_ptr<const Context> context) : context(std::move(context))
+{
+}
+
+bool PurityCheck::isPure(const Expression *expr)
+{
+  return !expr || expr->isPure(*this);
+}
+
+bool PurityCheck::isPure(const AssignmentList& assignments)
+{
+  return std::all_of(assignments.begin(), assignments.end(), [this](const auto& assignment) {
+    return isPure(assignment->getExpr().get());
+  });
+}
+
+bool PurityCheck::bindSequentially(const AssignmentList& assignments)
+{
+  for (const auto& assignment : assignments) {
+    if (!isPure(assignment->getExpr().get())) return false;
+    bind(assignment->getName());
+  }
+  return true;
+}
+
+bool PurityCheck::isBound(const std::string& name) const
+{
+  return std::find(bound.begin(), bound.end(), name) != bound.end();
+}
+
+bool PurityCheck::isPureVariable(const std::string& name)
+{
+  if (!isBound(name)) {
+    if (auto value = context->try_lookup_variable(name)) prepare(*value);
+  }
+  return true;
+}
+
+bool PurityCheck::isPureCall(const FunctionCall& call)
+{
+  if (!call.isLookup || isBound(call.get_name())) return false;
+  if (!isPure(call.arguments)) return false;
+
+  boost::optional<CallableFunction> function;
+  {
+    // Unknown functions are reported once they are actually called.
+    std::vector<Message> ignored;
+    MessageCapture capture(ignored);
+    function = context->lookup_function(call.get_name(), call.location());
+  }
+  if (!function) return true;
+
+  if (std::holds_alternative<const BuiltinFunction *>(*function)) {
+    return !isImpureBuiltin(call);
+  }
+  if (const auto *user = std::get_if<CallableUserFunction>(&*function)) {
+    return isPureFunction(user->defining_context, user->function->parameters, user->function->expr.get());
+  }
+  const Value *value = std::holds_alternative<Value>(*function) ? &std::get<Value>(*function) : std::get<const Value *>(*function);
+  const FunctionType& literal = value->toFunction();
+  return isPureFunction(literal.getContext(), *literal.getParameters(), literal.getExpr().get());
+}
+
+bool PurityCheck::isPureFunction(const std::shared_ptr<const Context>& definingContext, const AssignmentList& parameters, const Expression *expr)
+{
+  // Any impure function makes the whole check fail, so recursive calls
+  // and repeated calls can be assumed to be pure.
+  if (!checkedFunctions.emplace(expr, definingContext.get()).second) return true;
+
+  auto outerContext = std::exchange(context, definingContext);
+  auto outerBound = std::exchange(bound, std::vector<std::string>{});
+  bool pure = isPure(parameters);
+  for (const auto& parameter : parameters) bind(parameter->getName());
+  pure = pure && isPure(expr);
+  context = std::move(outerContext);
+  bound = std::move(outerBound);
+  return pure;
+}
+
+void PurityCheck::prepare(const Value& value)
+{
+  if (value.type() == Value::Type::VECTOR) {
+    value.toVector().flattenNested(preparedVectors);
+  }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <boost/functional/hash.hpp>
+
+#include "Assignment.h"
+
+class Context;
+class Expression;
+class FunctionCall;
+class Value;
+
+/**
+ * Decides whether an expression can be evaluated on a worker thread,
+ * concurrently with other evaluations of the same expression.
+ *
+ * A pure expression has no side effects: it doesn't echo(), assert(), draw
+ * unseeded random numbers or read files and fonts, and it only calls functions
+ * whose bodies are pure in turn. Calls are resolved against the context the
+ * expression is going to be evaluated in, which must stay unchanged while
+ * worker threads run. Calls through function values that are only known at
+ * evaluation time are considered impure.
+ *
+ * Vectors referenced by the expression are flattened while checking, since
+ * flattening them on first access from several threads at once is not safe.
+ */
+class PurityCheck
+{
+public:
+  PurityCheck(std::shared_ptr<const Context> context);
+
+  bool isPure(const Expression *expr);
+  bool isPure(const AssignmentList& assignments);
+
+  // Names bound while checking shadow those of the context.
+  void bind(const std::string& name) { bound.push_back(name); }
+  bool bindSequentially(const AssignmentList& assignments);
+
+  bool isPureVariable(const std::string& name);
+  bool isPureCall(const FunctionCall& call);
+
+  // Restores the bound names on destruction.
+  class Scope
+  {
+public:
+    Scope(PurityCheck& check) : check(check), size(check.bound.size()) {}
+    ~Scope() { check.bound.resize(size); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    PurityCheck& check;
+    size_t size;
+  };
+
+private:
+  bool isBound(const std::string& name) const;
+  bool isPureFunction(const std::shared_ptr<const Context>& definingContext, const AssignmentList& parameters, const Expression *expr);
+  void prepare(const Value& value);
+
+  std::shared_ptr<const Context> context;
+  std::vector<std::string> bound;
+  std::unordered_set<std::pair<const void *, const void *>, boost::hash<std::pair<const void *, const void *>>> checkedFunctions;
+  std::unordered_set<const void *> preparedVectors;
+};
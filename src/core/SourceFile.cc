@@ -32,6 +32,7 @@
 #include "ScopeContext.h"
 #include "parsersettings.h"
 #include "StatCache.h"
+#include "Trace.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <utility>
@@ -168,6 +169,8 @@ time_t SourceFile::handleDependencies(bool is_root)
 
 std::shared_ptr<AbstractNode> SourceFile::instantiate(const std::shared_ptr<const Context>& context, std::shared_ptr<const FileContext> *resulting_file_context) const
 {
+  Trace::Span span("evaluation", "SourceFile::instantiate");
+  span.arg("file", this->filename);
   auto node = std::make_shared<RootNode>();
   try {
     ContextHandle<FileContext> file_context{Context::create<FileContext>(context, this)};
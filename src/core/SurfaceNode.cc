@@ -264,8 +264,9 @@ const Geometry *SurfaceNode::createGeometry() const
   int columns = data.width;
   double min_val = data.min_value() - 1; // make the bottom solid, and match old code
 
-  // reserve the polygon vector size so we don't have to reallocate as often
-  p->polygons.reserve( (lines - 1) * (columns - 1) * 4 + (lines - 1) * 2 + (columns - 1) * 2 + 1);
+  // reserve the polygon and vertex storage so we don't have to reallocate as often
+  const size_t edges = (lines - 1) * 2 + (columns - 1) * 2;
+  p->reserve((lines - 1) * (columns - 1) * 4 + edges + 1, (lines - 1) * (columns - 1) * 12 + edges * 5);
 
   double ox = center ? -(columns - 1) / 2.0 : 0;
   double oy = center ? -(lines - 1) / 2.0 : 0;
@@ -344,7 +345,6 @@ const Geometry *SurfaceNode::createGeometry() const
   // the bottom of the shape (one less than the real minimum value), making it a solid volume
   if (columns > 1 && lines > 1) {
     p->append_poly();
-    p->polygons.back().reserve(2 * (columns - 1) + 2 * (lines - 1) ); // inelegant, could vertex count be argument to append_poly?  or separate call poly_reserve(x)?
     for (int i = 0; i < columns - 1; ++i)
       p->insert_vertex(ox + i, oy + 0, min_val);
     for (int i = 0; i < lines - 1; ++i)
@@ -36,6 +36,7 @@
 #include "Value.h"
 #include "Expression.h"
 #include "EvaluationSession.h"
+#include "VectorIndex.h"
 #include "printutils.h"
 #include "StackCheck.h"
 #include "boost-utils.h"
@@ -545,12 +546,14 @@ VectorType::VectorType(EvaluationSession *session) :
   ptr(shared_ptr<VectorObject>(new VectorObject(), VectorObjectDeleter() ))
 {
   ptr->evaluation_session = session;
+  ptr->owner = EvaluationSession::threadOwner();
 }
 
 VectorType::VectorType(class EvaluationSession *session, double x, double y, double z) :
   ptr(shared_ptr<VectorObject>(new VectorObject(), VectorObjectDeleter() ))
 {
   ptr->evaluation_session = session;
+  ptr->owner = EvaluationSession::threadOwner();
   emplace_back(x);
   emplace_back(y);
   emplace_back(z);
@@ -558,6 +561,7 @@ VectorType::VectorType(class EvaluationSession *session, double x, double y, dou
 
 void VectorType::emplace_back(Value&& val)
 {
+  ptr->search_index.reset();
   if (val.type() == Value::Type::EMBEDDED_VECTOR) {
     emplace_back(std::move(val.toEmbeddedVectorNonConst()));
   } else {
@@ -571,6 +575,7 @@ void VectorType::emplace_back(Value&& val)
 // Specialized handler for EmbeddedVectorTypes
 void VectorType::emplace_back(EmbeddedVectorType&& mbed)
 {
+  ptr->search_index.reset();
   if (mbed.size() > 1) {
     // embed_excess represents how many to add to vec.size() to get the total elements after flattening,
     // the embedded vector itself already counts towards an element in the parent's size, so subtract 1 from its size.
@@ -588,6 +593,50 @@ void VectorType::emplace_back(EmbeddedVectorType&& mbed)
   // else mbed.size() == 0, do nothing
 }
 
+VectorIndex *VectorType::searchIndex() const
+{
+  if (this->size() < VectorIndex::MIN_SIZE) return nullptr;
+  if (!EvaluationSession::isThreadOwned(ptr->owner)) return nullptr;
+  if (!ptr->search_index) ptr->search_index = std::make_unique<VectorIndex>();
+  return ptr->search_index->use() ? ptr->search_index.get() : nullptr;
+}
+
+const Value& VectorType::flattenedElement(size_t idx) const
+{
+  if (ptr->embed_excess == 0) return ptr->vec[idx];
+  if (EvaluationSession::isThreadOwned(ptr->owner)) {
+    flatten();
+    return ptr->vec[idx];
+  }
+  // Another thread's vector must not be modified; skip whole embedded vectors instead.
+  for (const auto& element : ptr->vec) {
+    if (element.type() != Value::Type::EMBEDDED_VECTOR) {
+      if (idx == 0) return element;
+      --idx;
+      continue;
+    }
+    const auto& embedded = std::get<EmbeddedVectorType>(element.value);
+    if (idx < embedded.size()) return embedded.flattenedElement(idx);
+    idx -= embedded.size();
+  }
+  assert(false && "index out of range");
+  return Value::undefined;
+}
+
+void VectorType::flattenNested(std::unordered_set<const void *>& visited) const
+{
+  std::vector<const VectorType *> pending{this};
+  while (!pending.empty()) {
+    const VectorType *vector = pending.back();
+    pending.pop_back();
+    if (!visited.insert(vector->ptr.get()).second) continue;
+    if (vector->ptr->embed_excess) vector->flatten();
+    for (const auto& element : vector->ptr->vec) {
+      if (element.type() == Value::Type::VECTOR) pending.push_back(&element.toVector());
+    }
+  }
+}
+
 void VectorType::flatten() const
 {
   vec_t ret;
@@ -4,11 +4,13 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <iostream>
 #include <memory>
 #include <type_traits>
+#include <unordered_set>
 #include <variant>
 
 #include <glib.h>
@@ -21,6 +23,7 @@ class tostream_visitor;
 class Context;
 class Expression;
 class Value;
+class VectorIndex;
 
 class QuotedString : public std::string
 {
@@ -179,7 +182,8 @@ using RangePtr = ValuePtr<RangeType>;
 class str_utf8_wrapper
 {
 private:
-  // store the cached length in glong, paired with its string
+  // store the cached length in glong, paired with its string. The length is
+  // filled in lazily, possibly by several evaluation threads at once.
   struct str_utf8_t {
     static constexpr glong LENGTH_UNKNOWN = -1;
     str_utf8_t() : u8str(), u8len(0) {
@@ -191,7 +195,7 @@ private:
     str_utf8_t(const char *cstr, size_t size, glong u8len) : u8str(cstr, size), u8len(u8len) {
     }
     const std::string u8str;
-    glong u8len = LENGTH_UNKNOWN;
+    std::atomic<glong> u8len{LENGTH_UNKNOWN};
   };
   // private constructor for copying members
   explicit str_utf8_wrapper(const shared_ptr<str_utf8_t>& str_in) : str_ptr(str_in) { }
@@ -247,10 +251,12 @@ private:
   [[nodiscard]] size_t size() const { return this->str_ptr->u8str.size(); }
 
   [[nodiscard]] glong get_utf8_strlen() const {
-    if (str_ptr->u8len == str_utf8_t::LENGTH_UNKNOWN) {
-      str_ptr->u8len = g_utf8_strlen(str_ptr->u8str.c_str(), static_cast<gssize>(str_ptr->u8str.size()));
+    glong u8len = str_ptr->u8len.load(std::memory_order_relaxed);
+    if (u8len == str_utf8_t::LENGTH_UNKNOWN) {
+      u8len = g_utf8_strlen(str_ptr->u8str.c_str(), static_cast<gssize>(str_ptr->u8str.size()));
+      str_ptr->u8len.store(u8len, std::memory_order_relaxed);
     }
-    return str_ptr->u8len;
+    return u8len;
   }
 
 private:
@@ -381,6 +387,8 @@ protected:
       vec_t vec;
       size_type embed_excess = 0; // Keep count of the number of embedded elements *excess of* vec.size()
       class EvaluationSession *evaluation_session = nullptr; // Used for heap size bookkeeping. May be null for vectors of known small maximum size.
+      uint64_t owner = 0; // EvaluationSession::threadOwner() of the creating thread. Only the owner may flatten or index the vector.
+      std::unique_ptr<VectorIndex> search_index; // Built on demand by searchIndex()
       [[nodiscard]] size_type size() const { return vec.size() + embed_excess;  }
     };
     using vec_t = VectorObject::vec_t;
@@ -398,6 +406,7 @@ protected:
     void flatten() const; // flatten replaces VectorObject::vec with a new vector
                           // where any embedded elements are copied directly into the top level vec,
                           // leaving only true elements for straightforward indexing by operator[].
+    const Value& flattenedElement(size_t idx) const; // flattens first, unless another thread may be reading this vector
     explicit VectorType(const shared_ptr<VectorObject>& copy) : ptr(copy) { } // called by clone()
 public:
     using size_type = VectorObject::size_type;
@@ -479,7 +488,7 @@ public:
     // const accesses to VectorObject require .clone to be move-able
     const Value& operator[](size_t idx) const {
       if (idx < this->size()) {
-        if (ptr->embed_excess) flatten();
+        if (ptr->embed_excess) return flattenedElement(idx);
         return ptr->vec[idx];
       } else {
         return Value::undefined;
@@ -492,6 +501,11 @@ public:
     Value operator<=(const VectorType& v) const;
     Value operator>=(const VectorType& v) const;
     [[nodiscard]] class EvaluationSession *evaluation_session() const { return ptr->evaluation_session; }
+    // Index for lookup() and search(), or nullptr if this vector is too small or not searched repeatedly.
+    [[nodiscard]] VectorIndex *searchIndex() const;
+    // Flattens this vector and the vectors nested in it, skipping those already visited,
+    // so that several threads can index them at once.
+    void flattenNested(std::unordered_set<const void *>& visited) const;
 
     void emplace_back(Value&& val);
     void emplace_back(EmbeddedVectorType&& mbed);
@@ -0,0 +1,75 @@
+#include "VectorIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// -0 and 0 compare equal, so they must share a bucket
+double normalized_key(double d)
+{
+  return d == 0.0 ? 0.0 : d;
+}
+
+} // namespace
+
+const std::vector<VectorIndex::LookupEntry>& VectorIndex::lookupEntries(const VectorType& table)
+{
+  if (!this->lookup_entries) {
+    std::vector<LookupEntry> entries;
+    entries.reserve(table.size());
+    for (const auto& element : table) {
+      double key, value;
+      // NaN keys never satisfy lookup()'s comparisons, so they can never be selected
+      if (element.getVec2(key, value) && !std::isnan(key)) entries.push_back({key, value});
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const LookupEntry& a, const LookupEntry& b) {
+      return a.key < b.key;
+    });
+    this->lookup_entries = std::move(entries);
+  }
+  return *this->lookup_entries;
+}
+
+const VectorIndex::Column& VectorIndex::column(const VectorType& table, unsigned int index_col_num)
+{
+  auto it = this->columns.find(index_col_num);
+  if (it != this->columns.end()) return it->second;
+
+  Column& col = this->columns[index_col_num];
+  uint32_t row = 0;
+  for (const auto& element : table) {
+    const Value *entry = nullptr;
+    if (element.type() == Value::Type::VECTOR) {
+      const auto& vec = element.toVector();
+      if (index_col_num < vec.size()) entry = &vec[index_col_num];
+    } else if (index_col_num == 0) {
+      entry = &element;
+    }
+    if (entry) {
+      if (entry->type() == Value::Type::NUMBER) {
+        double d = entry->toDouble();
+        if (!std::isnan(d)) col.numbers[normalized_key(d)].push_back(row);
+      } else if (entry->type() == Value::Type::STRING) {
+        col.strings[entry->toStrUtf8Wrapper().toString()].push_back(row);
+      }
+    }
+    ++row;
+  }
+  return col;
+}
+
+const VectorIndex::Rows *VectorIndex::find(const VectorType& table, unsigned int index_col_num, const Value& key)
+{
+  static const Rows none;
+  if (key.type() == Value::Type::NUMBER) {
+    const auto& numbers = column(table, index_col_num).numbers;
+    auto it = numbers.find(normalized_key(key.toDouble()));
+    return it != numbers.end() ? &it->second : &none;
+  } else if (key.type() == Value::Type::STRING) {
+    const auto& strings = column(table, index_col_num).strings;
+    auto it = strings.find(key.toStrUtf8Wrapper().toString());
+    return it != strings.end() ? &it->second : &none;
+  }
+  return nullptr;
+}
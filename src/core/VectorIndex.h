@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/optional.hpp>
+
+#include "Value.h"
+
+/**
+ * Search structures for vectors which are repeatedly passed to lookup() or search(),
+ * typically large constant tables referenced from within a loop.
+ *
+ * A VectorIndex is owned by the VectorObject it indexes, so it is shared by all
+ * Values referring to the same vector and lives exactly as long as the vector itself.
+ * Appending to the vector drops the index.
+ * The index only speeds up finding matching rows; callers must produce the same
+ * results, in the same order, as their linear scans.
+ */
+class VectorIndex
+{
+public:
+  // Smaller vectors are always scanned linearly
+  static constexpr size_t MIN_SIZE = 16;
+
+  using Rows = std::vector<uint32_t>;
+
+  struct LookupEntry {
+    double key;
+    double value;
+  };
+
+  // Register a search of the vector, returns true once it is searched often enough to be worth indexing.
+  bool use() { return ++this->uses > 1; }
+
+  // The valid [key, value] entries of a lookup() table, ordered by key, and by position for equal keys.
+  const std::vector<LookupEntry>& lookupEntries(const VectorType& table);
+
+  // Rows of a search() table matching key, either as a whole entry (index_col_num == 0 only)
+  // or as entry[index_col_num], in ascending order.
+  // Returns nullptr if key is not of a type the index supports (number or string).
+  const Rows *find(const VectorType& table, unsigned int index_col_num, const Value& key);
+
+private:
+  struct Column {
+    std::unordered_map<double, Rows> numbers;
+    std::unordered_map<std::string, Rows> strings;
+  };
+  const Column& column(const VectorType& table, unsigned int index_col_num);
+
+  unsigned int uses = 0;
+  boost::optional<std::vector<LookupEntry>> lookup_entries;
+  std::unordered_map<unsigned int, Column> columns;
+};
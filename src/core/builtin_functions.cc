@@ -34,6 +34,8 @@
 #include "degree_trig.h"
 #include "FreetypeRenderer.h"
 #include "Parameters.h"
+#include "VectorIndex.h"
+#include "parallel.h"
 #include "import.h"
 #include "fileutils.h"
 
@@ -158,9 +160,13 @@ Value builtin_rands(Arguments arguments, const Location& loc)
   }
   auto numresults = boost_numeric_cast<size_t, double>(numresultsd);
 
+  // Seeded calls are independent of earlier ones. Worker threads draw from
+  // their own generator so they can't race on the shared one.
+  std::mt19937 seeded_rng;
+  std::mt19937& rng = arguments.size() > 3 && Parallel::isWorker() ? seeded_rng : deterministic_rng;
   if (arguments.size() > 3) {
     auto seed = static_cast<uint32_t>(hash_floating_point(arguments[3]->toDouble() ));
-    deterministic_rng.seed(seed);
+    rng.seed(seed);
   }
 
   VectorType vec(arguments.session());
@@ -170,7 +176,7 @@ Value builtin_rands(Arguments arguments, const Location& loc)
   } else {
     std::uniform_real_distribution<> distributor(min, max);
     for (size_t i = 0; i < numresults; ++i) {
-      vec.emplace_back(distributor(deterministic_rng));
+      vec.emplace_back(distributor(rng));
     }
   }
   return std::move(vec);
@@ -337,8 +343,20 @@ Value builtin_exp(Arguments arguments, const Location& loc)
   return {exp(arguments[0]->toDouble())};
 }
 
-Value builtin_length(Arguments arguments, const Location& loc)
+Value builtin_length(const std::shared_ptr<const Context>& context, const FunctionCall *call)
 {
+  // len([for (...) ...]) only needs to count the generated elements
+  if (ListComprehension::lazyEvaluation() && call->arguments.size() == 1 && call->arguments[0]->getName().empty()) {
+    auto vector = dynamic_pointer_cast<Vector>(call->arguments[0]->getExpr());
+    if (vector && vector->isComprehension()) {
+      double count = 0;
+      vector->generate(context, [&count](Value&&) { ++count; });
+      return {count};
+    }
+  }
+
+  Arguments arguments{call->arguments, context};
+  const Location& loc = call->location();
   if (try_check_arguments(arguments, { Value::Type::VECTOR })) {
     return {double(arguments[0]->toVector().size())};
   }
@@ -449,16 +467,36 @@ Value builtin_lookup(Arguments arguments, const Location& loc)
   high_p = low_p;
   high_v = low_v;
 
-  for (++it; it != vec.end(); ++it) {
-    double this_p, this_v;
-    if (it->getVec2(this_p, this_v)) {
-      if (this_p <= p && (this_p > low_p || low_p > p)) {
-        low_p = this_p;
-        low_v = this_v;
-      }
-      if (this_p >= p && (this_p < high_p || high_p < p)) {
-        high_p = this_p;
-        high_v = this_v;
+  // Find the first entry with the greatest key <= p, and the first entry with the smallest key >= p,
+  // falling back to the first entry.
+  // A NaN key in the first entry is sticky, which the index doesn't model.
+  VectorIndex *index = std::isnan(low_p) ? nullptr : vec.searchIndex();
+  if (index) {
+    using Entry = VectorIndex::LookupEntry;
+    const auto& entries = index->lookupEntries(vec);
+    auto upper = std::upper_bound(entries.begin(), entries.end(), p, [](double p, const Entry& e) { return p < e.key; });
+    if (upper != entries.begin()) {
+      auto low = std::lower_bound(entries.begin(), upper, std::prev(upper)->key, [](const Entry& e, double key) { return e.key < key; });
+      low_p = low->key;
+      low_v = low->value;
+    }
+    auto high = std::lower_bound(entries.begin(), upper, p, [](const Entry& e, double p) { return e.key < p; });
+    if (high != entries.end()) {
+      high_p = high->key;
+      high_v = high->value;
+    }
+  } else {
+    for (++it; it != vec.end(); ++it) {
+      double this_p, this_v;
+      if (it->getVec2(this_p, this_v)) {
+        if (this_p <= p && (this_p > low_p || low_p > p)) {
+          low_p = this_p;
+          low_v = this_v;
+        }
+        if (this_p >= p && (this_p < high_p || high_p < p)) {
+          high_p = this_p;
+          high_v = this_v;
+        }
       }
     }
   }
@@ -606,6 +644,41 @@ static VectorType search(
   return returnvec;
 }
 
+/*
+   Calls found(j) for the index j of each entry in table matching find_value, in ascending order,
+   until num_returns_per_match matches were found (0 for all). Returns the number of matches.
+ */
+template <typename F>
+static unsigned int search(
+  const Value& find_value,
+  const VectorType& table,
+  unsigned int num_returns_per_match,
+  unsigned int index_col_num,
+  F found
+  ) {
+  unsigned int matchCount = 0;
+  VectorIndex *index = table.searchIndex();
+  if (const VectorIndex::Rows *rows = index ? index->find(table, index_col_num, find_value) : nullptr) {
+    for (auto j : *rows) {
+      found(j);
+      if (++matchCount == num_returns_per_match) break;
+    }
+    return matchCount;
+  }
+
+  size_t j = 0;
+  for (const auto& search_element : table) {
+    if ((index_col_num == 0 && (find_value == search_element).toBool()) ||
+        (index_col_num < search_element.toVector().size() &&
+         (find_value == search_element.toVector()[index_col_num]).toBool())) {
+      found(j);
+      if (++matchCount == num_returns_per_match) break;
+    }
+    ++j;
+  }
+  return matchCount;
+}
+
 Value builtin_search(Arguments arguments, const Location& loc)
 {
   if (arguments.size() < 2 || arguments.size() > 4) {
@@ -621,18 +694,9 @@ Value builtin_search(Arguments arguments, const Location& loc)
   VectorType returnvec(arguments.session());
 
   if (findThis.type() == Value::Type::NUMBER) {
-    unsigned int matchCount = 0;
-    size_t j = 0;
-    for (const auto& search_element : searchTable.toVector()) {
-      if ((index_col_num == 0 && (findThis == search_element).toBool()) ||
-          (index_col_num < search_element.toVector().size() &&
-           (findThis == search_element.toVector()[index_col_num]).toBool())) {
-        returnvec.emplace_back(double(j));
-        matchCount++;
-        if (num_returns_per_match != 0 && matchCount >= num_returns_per_match) break;
-      }
-      ++j;
-    }
+    search(findThis, searchTable.toVector(), num_returns_per_match, index_col_num, [&returnvec](size_t j) {
+      returnvec.emplace_back(double(j));
+    });
   } else if (findThis.type() == Value::Type::STRING) {
     if (searchTable.type() == Value::Type::STRING) {
       returnvec = search(findThis.toStrUtf8Wrapper(), searchTable.toStrUtf8Wrapper(), num_returns_per_match, arguments.session());
@@ -642,25 +706,15 @@ Value builtin_search(Arguments arguments, const Location& loc)
   } else if (findThis.type() == Value::Type::VECTOR) {
     const auto& findVec = findThis.toVector();
     for (const auto& find_value : findVec) {
-      unsigned int matchCount = 0;
       VectorType resultvec(arguments.session());
-
-      size_t j = 0;
-      for (const auto& search_element : searchTable.toVector()) {
-        if ((index_col_num == 0 && (find_value == search_element).toBool()) ||
-            (index_col_num < search_element.toVector().size() &&
-             (find_value == search_element.toVector()[index_col_num]).toBool())) {
-          matchCount++;
-          if (num_returns_per_match == 1) {
-            returnvec.emplace_back(double(j));
-            break;
-          } else {
-            resultvec.emplace_back(double(j));
-          }
-          if (num_returns_per_match > 1 && matchCount >= num_returns_per_match) break;
+      unsigned int matchCount = search(find_value, searchTable.toVector(), num_returns_per_match, index_col_num,
+                                       [&](size_t j) {
+        if (num_returns_per_match == 1) {
+          returnvec.emplace_back(double(j));
+        } else {
+          resultvec.emplace_back(double(j));
         }
-        ++j;
-      }
+      });
       if ((num_returns_per_match == 1 && matchCount == 0) ||
           num_returns_per_match == 0 ||
           num_returns_per_match > 1) {
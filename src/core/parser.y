@@ -44,6 +44,7 @@
 #include "function.h"
 #include "printutils.h"
 #include "memory.h"
+#include "Trace.h"
 #include <sstream>
 #include <stack>
 #include <boost/filesystem.hpp>
@@ -758,6 +759,8 @@ void handle_assignment(const std::string token, Expression *expr, const Location
 
 bool parse(SourceFile *&file, const std::string& text, const std::string &filename, const std::string &mainFile, int debug)
 {
+  Trace::Span span("parse", "parse");
+  span.arg("file", filename);
   fs::path filepath;
   try {
     filepath = fs::absolute(fs::path(filename));
@@ -34,9 +34,11 @@
 #include "printutils.h"
 #include "calc.h"
 #include "degree_trig.h"
+#include "PrimitiveTemplateCache.h"
 #include <sstream>
 #include <cassert>
 #include <cmath>
+#include <memory>
 #include <boost/assign/std/vector.hpp>
 #include "ModuleInstantiation.h"
 using namespace boost::assign; // bring 'operator+=()' into scope
@@ -60,6 +62,42 @@ static void generate_circle(point2d *circle, double r, int fragments)
   }
 }
 
+/*
+   Unit size tessellations of the round primitives.
+
+   How sphere(), cylinder() and circle() are tessellated only depends on their
+   number of fragments, and for cylinders on which radii are zero, so it is
+   computed once and shared by all instances. Instances copy the faces and
+   scale the unit vertices with the same operations as generate_circle(), so
+   their coordinates are exactly the same as if generated from scratch.
+ */
+struct PrimitiveTemplate {
+  std::vector<point2d> circle; // unit circle, as generate_circle()
+  std::vector<double> ringRadius, ringZ; // sphere rings, at unit radius
+  PolygonList faces; // vertex indices only; ring i starts at vertex i * fragments
+
+  [[nodiscard]] size_t memsize() const {
+    return sizeof(PrimitiveTemplate) + circle.capacity() * sizeof(point2d)
+           + (ringRadius.capacity() + ringZ.capacity()) * sizeof(double) + faces.memsize();
+  }
+};
+
+using PrimitiveTemplatePtr = std::shared_ptr<const PrimitiveTemplate>;
+
+template <typename Build>
+static PrimitiveTemplatePtr getPrimitiveTemplate(const std::string& key, int fragments, Build build)
+{
+  if (auto cached = PrimitiveTemplateCache::instance()->get(key)) {
+    return std::static_pointer_cast<const PrimitiveTemplate>(cached);
+  }
+  auto t = std::make_shared<PrimitiveTemplate>();
+  t->circle.resize(fragments);
+  generate_circle(t->circle.data(), 1.0, fragments);
+  build(*t);
+  PrimitiveTemplateCache::instance()->insert(key, t, t->memsize());
+  return t;
+}
+
 /**
  * Return a radius value by looking up both a diameter and radius variable.
  * The diameter has higher priority, so if found an additionally set radius
@@ -263,67 +301,59 @@ const Geometry *SphereNode::createGeometry() const
     return p;
   }
 
-  struct ring_s {
-    std::vector<point2d> points;
-    double z;
-  };
-
   auto fragments = Calc::get_fragments_from_r(r, fn, fs, fa);
   int rings = (fragments + 1) / 2;
 // Uncomment the following three lines to enable experimental sphere tessellation
 //	if (rings % 2 == 0) rings++; // To ensure that the middle ring is at phi == 0 degrees
 
-  auto ring = std::vector<ring_s>(rings);
-
+  auto tmpl = getPrimitiveTemplate("sphere " + std::to_string(fragments), fragments, [&](PrimitiveTemplate& t) {
+    t.ringRadius.resize(rings);
+    t.ringZ.resize(rings);
 //	double offset = 0.5 * ((fragments / 2) % 2);
-  for (int i = 0; i < rings; ++i) {
+    for (int i = 0; i < rings; ++i) {
 //		double phi = (180.0 * (i + offset)) / (fragments/2);
-    double phi = (180.0 * (i + 0.5)) / rings;
-    double radius = r * sin_degrees(phi);
-    ring[i].z = r * cos_degrees(phi);
-    ring[i].points.resize(fragments);
-    generate_circle(ring[i].points.data(), radius, fragments);
-  }
-
-  p->append_poly();
-  for (int i = 0; i < fragments; ++i)
-    p->append_vertex(ring[0].points[i].x, ring[0].points[i].y, ring[0].z);
-
-  for (int i = 0; i < rings - 1; ++i) {
-    auto r1 = &ring[i];
-    auto r2 = &ring[i + 1];
-    int r1i = 0, r2i = 0;
-    while (r1i < fragments || r2i < fragments) {
-      if (r1i >= fragments) goto sphere_next_r2;
-      if (r2i >= fragments) goto sphere_next_r1;
-      if ((double)r1i / fragments < (double)r2i / fragments) {
-sphere_next_r1:
-        p->append_poly();
-        int r1j = (r1i + 1) % fragments;
-        p->insert_vertex(r1->points[r1i].x, r1->points[r1i].y, r1->z);
-        p->insert_vertex(r1->points[r1j].x, r1->points[r1j].y, r1->z);
-        p->insert_vertex(r2->points[r2i % fragments].x, r2->points[r2i % fragments].y, r2->z);
-        r1i++;
-      } else {
-sphere_next_r2:
-        p->append_poly();
-        int r2j = (r2i + 1) % fragments;
-        p->append_vertex(r2->points[r2i].x, r2->points[r2i].y, r2->z);
-        p->append_vertex(r2->points[r2j].x, r2->points[r2j].y, r2->z);
-        p->append_vertex(r1->points[r1i % fragments].x, r1->points[r1i % fragments].y, r1->z);
-        r2i++;
+      double phi = (180.0 * (i + 0.5)) / rings;
+      t.ringRadius[i] = sin_degrees(phi);
+      t.ringZ[i] = cos_degrees(phi);
+    }
+
+    auto& faces = t.faces;
+    faces.beginPolygon();
+    for (int i = 0; i < fragments; ++i) faces.appendIndex(i);
+
+    for (int i = 0; i < rings - 1; ++i) {
+      const int r1 = i * fragments;
+      const int r2 = (i + 1) * fragments;
+      int r1i = 0, r2i = 0;
+      while (r1i < fragments || r2i < fragments) {
+        faces.beginPolygon();
+        if (r1i < fragments && (r2i >= fragments || r1i < r2i)) {
+          faces.appendIndex(r2 + r2i % fragments);
+          faces.appendIndex(r1 + (r1i + 1) % fragments);
+          faces.appendIndex(r1 + r1i);
+          r1i++;
+        } else {
+          faces.appendIndex(r2 + r2i);
+          faces.appendIndex(r2 + (r2i + 1) % fragments);
+          faces.appendIndex(r1 + r1i % fragments);
+          r2i++;
+        }
       }
     }
-  }
 
-  p->append_poly();
-  for (int i = 0; i < fragments; ++i) {
-    p->insert_vertex(
-      ring[rings - 1].points[i].x,
-      ring[rings - 1].points[i].y,
-      ring[rings - 1].z
-      );
+    faces.beginPolygon();
+    for (int i = fragments - 1; i >= 0; --i) faces.appendIndex((rings - 1) * fragments + i);
+  });
+
+  p->polygons = tmpl->faces;
+  auto& vertices = p->polygons.vertices;
+  vertices.reserve(rings * fragments);
+  for (int i = 0; i < rings; ++i) {
+    const double radius = r * tmpl->ringRadius[i];
+    const double z = r * tmpl->ringZ[i];
+    for (const auto& c : tmpl->circle) vertices.emplace_back(radius * c.x, radius * c.y, z);
   }
+  p->setDirty();
 
   return p;
 }
@@ -403,47 +433,54 @@ const Geometry *CylinderNode::createGeometry() const
     z2 = this->h;
   }
 
-  auto circle1 = std::vector<point2d>(fragments);
-  auto circle2 = std::vector<point2d>(fragments);
-
-  generate_circle(circle1.data(), r1, fragments);
-  generate_circle(circle2.data(), r2, fragments);
-
-  for (int i = 0; i < fragments; ++i) {
-    int j = (i + 1) % fragments;
-    if (r1 == r2) {
-      p->append_poly();
-      p->insert_vertex(circle1[i].x, circle1[i].y, z1);
-      p->insert_vertex(circle2[i].x, circle2[i].y, z2);
-      p->insert_vertex(circle2[j].x, circle2[j].y, z2);
-      p->insert_vertex(circle1[j].x, circle1[j].y, z1);
-    } else {
-      if (r1 > 0) {
-        p->append_poly();
-        p->insert_vertex(circle1[i].x, circle1[i].y, z1);
-        p->insert_vertex(circle2[i].x, circle2[i].y, z2);
-        p->insert_vertex(circle1[j].x, circle1[j].y, z1);
-      }
-      if (r2 > 0) {
-        p->append_poly();
-        p->insert_vertex(circle2[i].x, circle2[i].y, z2);
-        p->insert_vertex(circle2[j].x, circle2[j].y, z2);
-        p->insert_vertex(circle1[j].x, circle1[j].y, z1);
+  // Bottom vertices come first, then top ones.
+  const bool prism = r1 == r2;
+  const bool bottom = r1 > 0;
+  const bool top = r2 > 0;
+  const auto key = "cylinder " + std::to_string(fragments) + (prism ? " prism" : "") + (bottom ? " bottom" : "") + (top ? " top" : "");
+  auto tmpl = getPrimitiveTemplate(key, fragments, [&](PrimitiveTemplate& t) {
+    auto& faces = t.faces;
+    for (int i = 0; i < fragments; ++i) {
+      int j = (i + 1) % fragments;
+      if (prism) {
+        faces.beginPolygon();
+        faces.appendIndex(j);
+        faces.appendIndex(fragments + j);
+        faces.appendIndex(fragments + i);
+        faces.appendIndex(i);
+      } else {
+        if (bottom) {
+          faces.beginPolygon();
+          faces.appendIndex(j);
+          faces.appendIndex(fragments + i);
+          faces.appendIndex(i);
+        }
+        if (top) {
+          faces.beginPolygon();
+          faces.appendIndex(j);
+          faces.appendIndex(fragments + j);
+          faces.appendIndex(fragments + i);
+        }
       }
     }
-  }
 
-  if (this->r1 > 0) {
-    p->append_poly();
-    for (int i = 0; i < fragments; ++i)
-      p->insert_vertex(circle1[i].x, circle1[i].y, z1);
-  }
+    if (bottom) {
+      faces.beginPolygon();
+      for (int i = fragments - 1; i >= 0; --i) faces.appendIndex(i);
+    }
 
-  if (this->r2 > 0) {
-    p->append_poly();
-    for (int i = 0; i < fragments; ++i)
-      p->append_vertex(circle2[i].x, circle2[i].y, z2);
-  }
+    if (top) {
+      faces.beginPolygon();
+      for (int i = 0; i < fragments; ++i) faces.appendIndex(fragments + i);
+    }
+  });
+
+  p->polygons = tmpl->faces;
+  auto& vertices = p->polygons.vertices;
+  vertices.reserve(2 * fragments);
+  for (const auto& c : tmpl->circle) vertices.emplace_back(r1 * c.x, r1 * c.y, z1);
+  for (const auto& c : tmpl->circle) vertices.emplace_back(r2 * c.x, r2 * c.y, z2);
+  p->setDirty();
 
   return p;
 }
@@ -756,12 +793,10 @@ const Geometry *CircleNode::createGeometry() const
   }
 
   auto fragments = Calc::get_fragments_from_r(this->r, this->fn, this->fs, this->fa);
+  auto tmpl = getPrimitiveTemplate("circle " + std::to_string(fragments), fragments, [](PrimitiveTemplate&) {});
   Outline2d o;
-  o.vertices.resize(fragments);
-  for (int i = 0; i < fragments; ++i) {
-    double phi = (360.0 * i) / fragments;
-    o.vertices[i] = {this->r * cos_degrees(phi), this->r * sin_degrees(phi)};
-  }
+  o.vertices.reserve(fragments);
+  for (const auto& c : tmpl->circle) o.vertices.emplace_back(this->r * c.x, this->r * c.y);
   p->addOutline(o);
   p->setSanitized(true);
   return p;
@@ -1,5 +1,11 @@
 #include "ClipperUtils.h"
+#include "parallel.h"
 #include "printutils.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
 
 namespace ClipperUtils {
 
@@ -119,6 +125,60 @@ ClipperLib::Paths process(const ClipperLib::Paths& polygons,
   return result;
 }
 
+/*!
+   Unions many polygons, such as the triangles of a projected mesh, on several
+   threads. The polygons are split into strips along the longer side of their
+   bounds, each strip is unioned on its own thread, and the strips' outlines
+   are unioned at last. They are far fewer than the input polygons.
+ */
+ClipperLib::Paths unionTiles(const ClipperLib::Paths& polygons, ClipperLib::PolyFillType fillType)
+{
+  // Below this, starting threads costs more than it saves.
+  constexpr size_t minPolygonsPerTile = 1000;
+  const size_t numTiles = std::min<size_t>(Parallel::concurrency(), polygons.size() / minPolygonsPerTile);
+  if (numTiles < 2 || Parallel::isWorker()) return process(polygons, ClipperLib::ctUnion, fillType);
+
+  Trace::Span span("geometry", "unionTiles");
+  span.arg("polygons", polygons.size());
+
+  // Sort polygons by the position of their first vertex along the longer axis.
+  ClipperLib::IntRect bounds{ClipperLib::hiRange, ClipperLib::hiRange, -ClipperLib::hiRange, -ClipperLib::hiRange};
+  for (const auto& polygon : polygons) {
+    if (polygon.empty()) continue;
+    bounds.left = std::min(bounds.left, polygon.front().X);
+    bounds.right = std::max(bounds.right, polygon.front().X);
+    bounds.top = std::min(bounds.top, polygon.front().Y);
+    bounds.bottom = std::max(bounds.bottom, polygon.front().Y);
+  }
+  const bool alongX = bounds.right - bounds.left >= bounds.bottom - bounds.top;
+  std::vector<size_t> order(polygons.size());
+  std::iota(order.begin(), order.end(), 0);
+  const auto position = [&](size_t i) -> ClipperLib::cInt {
+      if (polygons[i].empty()) return 0;
+      return alongX ? polygons[i].front().X : polygons[i].front().Y;
+    };
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return position(a) < position(b); });
+
+  std::vector<ClipperLib::Paths> tiles(numTiles);
+  Parallel::run(numTiles, [&](size_t tile) {
+    Trace::Span tileSpan("geometry", "unionTiles tile");
+    const size_t begin = order.size() * tile / numTiles;
+    const size_t end = order.size() * (tile + 1) / numTiles;
+    ClipperLib::Paths paths;
+    paths.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) paths.push_back(polygons[order[i]]);
+    tiles[tile] = process(paths, ClipperLib::ctUnion, fillType);
+  });
+
+  // Each tile's outlines wind once around what it covers, and its holes are
+  // reversed, so a nonzero union of the tiles merges them correctly.
+  ClipperLib::Clipper clipper;
+  for (const auto& tile : tiles) clipper.AddPaths(tile, ClipperLib::ptSubject, true);
+  ClipperLib::Paths result;
+  clipper.Execute(ClipperLib::ctUnion, result, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+  return result;
+}
+
 /*!
    Apply the clipper operator to the given paths.
 
@@ -187,6 +247,115 @@ Polygon2d *apply(const std::vector<const Polygon2d *>& polygons,
   return res;
 }
 
+/*!
+   Applies a union or difference to many polygons, using several threads.
+
+   All polygons are converted to one fixed point space and sanitized on
+   several threads. Polygons whose x ranges overlap, directly or through
+   others, form a cluster. Clusters can't affect each other, so runs of them
+   are unioned on separate threads and their outlines put side by side.
+   A difference subtracts the union of all but the first polygon from it.
+
+   Other operations, and too few polygons to be worth splitting, are handled
+   by apply().
+ */
+Polygon2d *applyBatched(const std::vector<const Polygon2d *>& polygons, ClipperLib::ClipType clipType)
+{
+  // Below this, starting threads costs more than it saves.
+  constexpr size_t minPolygonsPerGroup = 64;
+  const bool isDifference = clipType == ClipperLib::ctDifference;
+  const size_t numOperands = polygons.size() - (isDifference ? 1 : 0);
+  const size_t numThreads = std::min<size_t>(Parallel::concurrency(), numOperands / minPolygonsPerGroup);
+  if ((clipType != ClipperLib::ctUnion && !isDifference) || numThreads < 2 || Parallel::isWorker()) {
+    return apply(polygons, clipType);
+  }
+
+  Trace::Span span("geometry", "applyBatched");
+  span.arg("polygons", polygons.size());
+
+  BoundingBox bounds;
+  for (auto polygon : polygons) {
+    if (polygon) bounds.extend(polygon->getBoundingBox());
+  }
+  const int pow2 = ClipperUtils::getScalePow2(bounds);
+
+  std::vector<ClipperLib::Paths> pathsvector(polygons.size());
+  Parallel::run(numThreads, [&](size_t thread) {
+    for (size_t i = thread; i < polygons.size(); i += numThreads) {
+      if (!polygons[i]) continue;
+      pathsvector[i] = fromPolygon2d(*polygons[i], pow2);
+      if (!polygons[i]->isSanitized()) ClipperLib::PolyTreeToPaths(sanitize(pathsvector[i]), pathsvector[i]);
+    }
+  });
+
+  // Sort the operands by the left end of their x range, and split them
+  // where none of the ones before reaches the next.
+  struct Operand {
+    size_t index;
+    ClipperLib::cInt left, right;
+  };
+  std::vector<Operand> operands;
+  for (size_t i = isDifference ? 1 : 0; i < pathsvector.size(); ++i) {
+    Operand operand{i, ClipperLib::hiRange, -ClipperLib::hiRange};
+    for (const auto& path : pathsvector[i]) {
+      for (const auto& point : path) {
+        operand.left = std::min(operand.left, point.X);
+        operand.right = std::max(operand.right, point.X);
+      }
+    }
+    if (operand.left <= operand.right) operands.push_back(operand);
+  }
+  std::sort(operands.begin(), operands.end(), [](const Operand& a, const Operand& b) { return a.left < b.left; });
+  std::vector<size_t> clusterStarts;
+  ClipperLib::cInt right = -ClipperLib::hiRange;
+  for (size_t i = 0; i < operands.size(); ++i) {
+    if (i == 0 || operands[i].left > right) clusterStarts.push_back(i);
+    right = std::max(right, operands[i].right);
+  }
+  span.arg("clusters", clusterStarts.size());
+
+  // Group consecutive clusters into runs of about the same number of operands.
+  const size_t numGroups = std::min(numThreads, clusterStarts.size());
+  std::vector<size_t> groupStarts;
+  for (size_t cluster = 0; cluster < clusterStarts.size(); ++cluster) {
+    if (groupStarts.size() * operands.size() <= clusterStarts[cluster] * numGroups) {
+      groupStarts.push_back(clusterStarts[cluster]);
+    }
+  }
+  groupStarts.push_back(operands.size());
+
+  std::vector<ClipperLib::PolyTree> unions(groupStarts.size() - 1);
+  Parallel::run(unions.size(), [&](size_t group) {
+    Trace::Span groupSpan("geometry", "applyBatched group");
+    ClipperLib::Clipper clipper;
+    for (size_t i = groupStarts[group]; i < groupStarts[group + 1]; ++i) {
+      clipper.AddPaths(pathsvector[operands[i].index], ClipperLib::ptSubject, true);
+    }
+    clipper.Execute(ClipperLib::ctUnion, unions[group], ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+  });
+
+  if (isDifference) {
+    ClipperLib::Clipper clipper;
+    clipper.AddPaths(pathsvector[0], ClipperLib::ptSubject, true);
+    for (const auto& tree : unions) {
+      ClipperLib::Paths paths;
+      ClipperLib::PolyTreeToPaths(tree, paths);
+      clipper.AddPaths(paths, ClipperLib::ptClip, true);
+    }
+    ClipperLib::PolyTree result;
+    clipper.Execute(ClipperLib::ctDifference, result, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+    return toPolygon2d(result, pow2);
+  }
+
+  auto result = new Polygon2d;
+  for (const auto& tree : unions) {
+    std::unique_ptr<Polygon2d> group(toPolygon2d(tree, pow2));
+    for (const auto& outline : group->outlines()) result->addOutline(outline);
+  }
+  result->setSanitized(true);
+  return result;
+}
+
 // This is a copy-paste from ClipperLib with the modification that the union operation is not performed
 // The reason is numeric robustness. With the insides missing, the intersection points created by the union operation may
 // (due to rounding) be located at slightly different locations than the original geometry and this
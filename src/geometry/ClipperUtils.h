@@ -20,7 +20,9 @@ Polygon2d *sanitize(const Polygon2d& poly);
 Polygon2d *toPolygon2d(const ClipperLib::PolyTree& poly, int pow2);
 ClipperLib::Paths process(const ClipperLib::Paths& polygons,
                           ClipperLib::ClipType, ClipperLib::PolyFillType);
+ClipperLib::Paths unionTiles(const ClipperLib::Paths& polygons, ClipperLib::PolyFillType);
 Polygon2d *applyOffset(const Polygon2d& poly, double offset, ClipperLib::JoinType joinType, double miter_limit, double arc_tolerance);
 Polygon2d *applyMinkowski(const std::vector<const Polygon2d *>& polygons);
 Polygon2d *apply(const std::vector<const Polygon2d *>& polygons, ClipperLib::ClipType);
+Polygon2d *applyBatched(const std::vector<const Polygon2d *>& polygons, ClipperLib::ClipType);
 }
@@ -0,0 +1,609 @@
+#include "EarClipping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+
+#include "Polygon2d.h"
+
+namespace EarClipping {
+
+namespace {
+
+struct Node {
+  Node(int i, double x, double y) : i(i), x(x), y(y) {}
+
+  int i; // vertex index
+  double x, y;
+  Node *prev = nullptr; // along the contour
+  Node *next = nullptr;
+  uint32_t z = 0; // position on the z-order curve
+  Node *prevZ = nullptr; // along the z-order curve
+  Node *nextZ = nullptr;
+};
+
+// Twice the signed area of pqr, positive if it turns left.
+double cross(const Node *p, const Node *q, const Node *r)
+{
+  return (q->x - p->x) * (r->y - p->y) - (q->y - p->y) * (r->x - p->x);
+}
+
+int sign(double v) { return (v > 0) - (v < 0); }
+
+bool equals(const Node *p, const Node *q) { return p->x == q->x && p->y == q->y; }
+
+// Whether p is inside the counter-clockwise triangle abc, or on its border.
+bool pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+{
+  return (cx - px) * (ay - py) >= (ax - px) * (cy - py)
+         && (ax - px) * (by - py) >= (bx - px) * (ay - py)
+         && (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+// Same as pointInTriangle(), except for a copy of a, as made by a bridge to a
+// hole, which doesn't block the ear.
+bool pointInTriangleExceptFirst(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+{
+  return !(ax == px && ay == py) && pointInTriangle(ax, ay, bx, by, cx, cy, px, py);
+}
+
+// Whether q lies within the bounding box of segment pr, for collinear p, q and r.
+bool onSegment(const Node *p, const Node *q, const Node *r)
+{
+  return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x)
+         && q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+}
+
+// Whether segments p1q1 and p2q2 intersect, or touch.
+bool intersects(const Node *p1, const Node *q1, const Node *p2, const Node *q2)
+{
+  const int o1 = sign(cross(p1, q1, p2));
+  const int o2 = sign(cross(p1, q1, q2));
+  const int o3 = sign(cross(p2, q2, p1));
+  const int o4 = sign(cross(p2, q2, q1));
+  if (o1 != o2 && o3 != o4) return true;
+  if (o1 == 0 && onSegment(p1, p2, q1)) return true;
+  if (o2 == 0 && onSegment(p1, q2, q1)) return true;
+  if (o3 == 0 && onSegment(p2, p1, q2)) return true;
+  if (o4 == 0 && onSegment(p2, q1, q2)) return true;
+  return false;
+}
+
+// Whether diagonal ab crosses an edge of the contour of a, other than the
+// ones at its ends.
+bool intersectsPolygon(const Node *a, const Node *b)
+{
+  const Node *p = a;
+  do {
+    if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i
+        && intersects(p, p->next, a, b)) return true;
+    p = p->next;
+  } while (p != a);
+  return false;
+}
+
+// Whether diagonal ab starts into the inside of the contour at a.
+bool locallyInside(const Node *a, const Node *b)
+{
+  return cross(a->prev, a, a->next) > 0
+    ? cross(a, b, a->next) <= 0 && cross(a, a->prev, b) <= 0
+    : cross(a, b, a->prev) > 0 || cross(a, a->next, b) > 0;
+}
+
+// Whether the middle of diagonal ab is inside the contour.
+bool middleInside(const Node *a, const Node *b)
+{
+  const double px = (a->x + b->x) / 2;
+  const double py = (a->y + b->y) / 2;
+  bool inside = false;
+  const Node *p = a;
+  do {
+    if ((p->y > py) != (p->next->y > py) && p->next->y != p->y
+        && px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x) {
+      inside = !inside;
+    }
+    p = p->next;
+  } while (p != a);
+  return inside;
+}
+
+// Whether the sector of the contour at m contains the sector at p, when both
+// are at the same place.
+bool sectorContainsSector(const Node *m, const Node *p)
+{
+  return cross(m->prev, m, p->prev) > 0 && cross(p->next, m, m->next) > 0;
+}
+
+// Whether ab can split the contour into two.
+bool isValidDiagonal(const Node *a, const Node *b)
+{
+  return a->next->i != b->i && a->prev->i != b->i && !intersectsPolygon(a, b)
+         && ((locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b)
+              // doesn't create sectors facing each other
+              && (cross(a->prev, a, b->prev) != 0 || cross(a, b->prev, b) != 0))
+             // zero length diagonal between two convex corners
+             || (equals(a, b) && cross(a->prev, a, a->next) < 0 && cross(b->prev, b, b->next) < 0));
+}
+
+Node *getLeftmost(Node *start)
+{
+  Node *leftmost = start;
+  Node *p = start;
+  do {
+    if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y)) leftmost = p;
+    p = p->next;
+  } while (p != start);
+  return leftmost;
+}
+
+void removeNode(Node *p)
+{
+  p->next->prev = p->prev;
+  p->prev->next = p->next;
+  if (p->prevZ) p->prevZ->nextZ = p->nextZ;
+  if (p->nextZ) p->nextZ->prevZ = p->prevZ;
+}
+
+double signedArea(const VectorOfVector2d& vertices)
+{
+  double area = 0;
+  for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+    area += (vertices[j][0] - vertices[i][0]) * (vertices[i][1] + vertices[j][1]);
+  }
+  return area / 2;
+}
+
+bool pointInOutline(const Vector2d& p, const VectorOfVector2d& vertices)
+{
+  bool inside = false;
+  for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+    const auto& a = vertices[i];
+    const auto& b = vertices[j];
+    if ((a[1] > p[1]) != (b[1] > p[1])
+        && p[0] < (b[0] - a[0]) * (p[1] - a[1]) / (b[1] - a[1]) + a[0]) inside = !inside;
+  }
+  return inside;
+}
+
+/*!
+   Triangulates one outline and the holes in it. The contours are kept as
+   circular doubly linked lists of nodes, from which ears are removed.
+ */
+class Triangulator
+{
+public:
+  explicit Triangulator(std::vector<IndexedTriangle>& triangles) : triangles(triangles) {}
+
+  // Adds a contour, oriented counter-clockwise or clockwise, and returns its
+  // last node.
+  Node *addContour(const VectorOfVector2d& vertices, int first, bool ccw)
+  {
+    Node *last = nullptr;
+    if (ccw == (signedArea(vertices) > 0)) {
+      for (size_t i = 0; i < vertices.size(); ++i) last = insertNode(first + i, vertices[i], last);
+    } else {
+      for (size_t i = vertices.size(); i-- > 0;) last = insertNode(first + i, vertices[i], last);
+    }
+    if (last && last != last->next && equals(last, last->next)) {
+      removeNode(last);
+      last = last->next;
+    }
+    for (const auto& v : vertices) {
+      minX = std::min(minX, v[0]);
+      minY = std::min(minY, v[1]);
+      maxX = std::max(maxX, v[0]);
+      maxY = std::max(maxY, v[1]);
+    }
+    return last;
+  }
+
+  void triangulate(Node *outer, const std::vector<Node *>& holes)
+  {
+    if (!outer || outer->next == outer->prev) return;
+    if (!holes.empty()) outer = eliminateHoles(outer, holes);
+
+    // Finding the vertices inside an ear through the z-order curve only
+    // pays off for bigger contours.
+    if (nodes.size() > 80) {
+      const double size = std::max(maxX - minX, maxY - minY);
+      invSize = size != 0 ? 32767 / size : 0;
+    }
+    cutEars(outer, 0);
+  }
+
+private:
+  Node *insertNode(int i, const Vector2d& v, Node *last)
+  {
+    Node *p = &nodes.emplace_back(i, v[0], v[1]);
+    if (!last) {
+      p->prev = p;
+      p->next = p;
+    } else {
+      p->next = last->next;
+      p->prev = last;
+      last->next->prev = p;
+      last->next = p;
+    }
+    return p;
+  }
+
+  // Removes duplicate and collinear consecutive points between start and end.
+  Node *filterPoints(Node *start, Node *end = nullptr)
+  {
+    if (!start) return start;
+    if (!end) end = start;
+    Node *p = start;
+    bool again;
+    do {
+      again = false;
+      if (equals(p, p->next) || cross(p->prev, p, p->next) == 0) {
+        removeNode(p);
+        p = end = p->prev;
+        if (p == p->next) break;
+        again = true;
+      } else {
+        p = p->next;
+      }
+    } while (again || p != end);
+    return end;
+  }
+
+  // Links a copy of a and b with a diagonal from a to b, splitting their
+  // contour into two, or joining two contours into one. Returns the copy of b.
+  Node *splitPolygon(Node *a, Node *b)
+  {
+    Node *a2 = &nodes.emplace_back(a->i, a->x, a->y);
+    Node *b2 = &nodes.emplace_back(b->i, b->x, b->y);
+    Node *an = a->next;
+    Node *bp = b->prev;
+
+    a->next = b;
+    b->prev = a;
+    a2->next = an;
+    an->prev = a2;
+    b2->next = a2;
+    a2->prev = b2;
+    bp->next = b2;
+    b2->prev = bp;
+    return b2;
+  }
+
+  // Joins the holes to the outer contour, from left to right.
+  Node *eliminateHoles(Node *outer, const std::vector<Node *>& holes)
+  {
+    std::vector<Node *> leftmost;
+    for (auto *hole : holes) {
+      if (hole) leftmost.push_back(getLeftmost(hole));
+    }
+    std::sort(leftmost.begin(), leftmost.end(), [](const Node *a, const Node *b) {
+      return a->x < b->x || (a->x == b->x && a->y < b->y);
+    });
+    for (auto *hole : leftmost) {
+      Node *bridge = findHoleBridge(hole, outer);
+      // An unbridged hole makes the triangles cover it, which the caller notices
+      if (!bridge) continue;
+      Node *bridgeReverse = splitPolygon(bridge, hole);
+      filterPoints(bridgeReverse, bridgeReverse->next);
+      outer = filterPoints(bridge, bridge->next);
+    }
+    return outer;
+  }
+
+  // Finds a vertex of the outer contour which can be joined to the leftmost
+  // vertex of a hole without crossing any edge (David Eberly).
+  Node *findHoleBridge(Node *hole, Node *outer)
+  {
+    const double hx = hole->x;
+    const double hy = hole->y;
+    double qx = -std::numeric_limits<double>::infinity();
+    Node *m = nullptr;
+
+    // Find the closest edge left of the hole, crossed by a horizontal ray
+    Node *p = outer;
+    do {
+      if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+        const double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+        if (x <= hx && x > qx) {
+          qx = x;
+          m = p->x < p->next->x ? p : p->next;
+          // The hole touches the edge
+          if (x == hx) return m;
+        }
+      }
+      p = p->next;
+    } while (p != outer);
+    if (!m) return nullptr;
+
+    // Vertices inside the triangle between the hole, the crossing point and
+    // the end of the edge could hide the end from the hole. If there are any,
+    // take the one with the smallest angle to the ray.
+    const Node *stop = m;
+    const double mx = m->x;
+    const double my = m->y;
+    double tanMin = std::numeric_limits<double>::infinity();
+    p = m;
+    do {
+      if (hx >= p->x && p->x >= mx && hx != p->x
+          && pointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+        const double tan = std::abs(hy - p->y) / (hx - p->x);
+        if (locallyInside(p, hole)
+            && (tan < tanMin || (tan == tanMin && (p->x > m->x || (p->x == m->x && sectorContainsSector(m, p)))))) {
+          m = p;
+          tanMin = tan;
+        }
+      }
+      p = p->next;
+    } while (p != stop);
+    return m;
+  }
+
+  uint32_t zOrder(double px, double py) const
+  {
+    // Coordinates as 15 bit integers, with their bits interleaved
+    auto x = static_cast<uint32_t>((px - minX) * invSize);
+    auto y = static_cast<uint32_t>((py - minY) * invSize);
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    y = (y | (y << 8)) & 0x00FF00FF;
+    y = (y | (y << 4)) & 0x0F0F0F0F;
+    y = (y | (y << 2)) & 0x33333333;
+    y = (y | (y << 1)) & 0x55555555;
+    return x | (y << 1);
+  }
+
+  // Links the nodes of a contour along the z-order curve.
+  void indexCurve(Node *start)
+  {
+    std::vector<Node *> curve;
+    Node *p = start;
+    do {
+      p->z = zOrder(p->x, p->y);
+      curve.push_back(p);
+      p = p->next;
+    } while (p != start);
+    std::stable_sort(curve.begin(), curve.end(), [](const Node *a, const Node *b) { return a->z < b->z; });
+    for (size_t k = 0; k < curve.size(); ++k) {
+      curve[k]->prevZ = k > 0 ? curve[k - 1] : nullptr;
+      curve[k]->nextZ = k + 1 < curve.size() ? curve[k + 1] : nullptr;
+    }
+  }
+
+  // An ear is a convex corner with no reflex vertex inside it. Convex
+  // vertices can't be inside without a reflex one being inside too.
+  bool isEar(const Node *ear) const
+  {
+    const Node *a = ear->prev;
+    const Node *b = ear;
+    const Node *c = ear->next;
+    if (cross(a, b, c) <= 0) return false;
+
+    for (const Node *p = c->next; p != a; p = p->next) {
+      if (pointInTriangleExceptFirst(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y)
+          && cross(p->prev, p, p->next) <= 0) return false;
+    }
+    return true;
+  }
+
+  // Same as isEar(), only looking at the vertices in the range of the
+  // z-order curve covered by the bounding box of the ear.
+  bool isEarHashed(const Node *ear) const
+  {
+    const Node *a = ear->prev;
+    const Node *b = ear;
+    const Node *c = ear->next;
+    if (cross(a, b, c) <= 0) return false;
+
+    const double x0 = std::min({a->x, b->x, c->x});
+    const double y0 = std::min({a->y, b->y, c->y});
+    const double x1 = std::max({a->x, b->x, c->x});
+    const double y1 = std::max({a->y, b->y, c->y});
+    const uint32_t minZ = zOrder(x0, y0);
+    const uint32_t maxZ = zOrder(x1, y1);
+
+    auto hidesEar = [&](const Node *p) {
+        return p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && p != a && p != c
+               && pointInTriangleExceptFirst(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y)
+               && cross(p->prev, p, p->next) <= 0;
+      };
+    const Node *p = ear->prevZ;
+    const Node *n = ear->nextZ;
+    while (p && p->z >= minZ && n && n->z <= maxZ) {
+      if (hidesEar(p) || hidesEar(n)) return false;
+      p = p->prevZ;
+      n = n->nextZ;
+    }
+    for (; p && p->z >= minZ; p = p->prevZ) {
+      if (hidesEar(p)) return false;
+    }
+    for (; n && n->z <= maxZ; n = n->nextZ) {
+      if (hidesEar(n)) return false;
+    }
+    return true;
+  }
+
+  // Cuts off the ears of a contour. When none is left before the contour is
+  // done, each pass tries a stronger fix before carrying on.
+  void cutEars(Node *ear, int pass)
+  {
+    if (!ear) return;
+    if (pass == 0 && invSize != 0) indexCurve(ear);
+
+    Node *stop = ear;
+    while (ear->prev != ear->next) {
+      Node *prev = ear->prev;
+      Node *next = ear->next;
+      if (invSize != 0 ? isEarHashed(ear) : isEar(ear)) {
+        triangles.emplace_back(prev->i, ear->i, next->i);
+        removeNode(ear);
+        // Skipping the next vertex gives fewer sliver triangles
+        ear = next->next;
+        stop = next->next;
+        continue;
+      }
+      ear = next;
+      if (ear == stop) {
+        if (pass == 0) cutEars(filterPoints(ear), 1);
+        else if (pass == 1) cutEars(cureLocalIntersections(filterPoints(ear)), 2);
+        else splitCutEars(ear);
+        break;
+      }
+    }
+  }
+
+  // Cuts off small self-intersections, where two edges next to each other
+  // cross.
+  Node *cureLocalIntersections(Node *start)
+  {
+    Node *p = start;
+    do {
+      Node *a = p->prev;
+      Node *b = p->next->next;
+      if (!equals(a, b) && intersects(a, p, p->next, b) && locallyInside(a, b) && locallyInside(b, a)) {
+        triangles.emplace_back(a->i, p->i, b->i);
+        removeNode(p);
+        removeNode(p->next);
+        p = start = b;
+      }
+      p = p->next;
+    } while (p != start);
+    return filterPoints(p);
+  }
+
+  // Splits the contour along a valid diagonal and triangulates both halves.
+  void splitCutEars(Node *start)
+  {
+    Node *a = start;
+    do {
+      for (Node *b = a->next->next; b != a->prev; b = b->next) {
+        if (a->i != b->i && isValidDiagonal(a, b)) {
+          Node *c = splitPolygon(a, b);
+          a = filterPoints(a, a->next);
+          c = filterPoints(c, c->next);
+          cutEars(a, 0);
+          cutEars(c, 0);
+          return;
+        }
+      }
+      a = a->next;
+    } while (a != start);
+  }
+
+  std::vector<IndexedTriangle>& triangles;
+  std::deque<Node> nodes;
+  double minX = std::numeric_limits<double>::infinity();
+  double minY = std::numeric_limits<double>::infinity();
+  double maxX = -std::numeric_limits<double>::infinity();
+  double maxY = -std::numeric_limits<double>::infinity();
+  double invSize = 0; // scale to z-order coordinates, or 0 to not use it
+};
+
+} // namespace
+
+bool triangulate(const Polygon2d& polygon, std::vector<IndexedTriangle>& triangles)
+{
+  struct Contour {
+    const VectorOfVector2d *vertices;
+    int first; // index of the first vertex
+    double area; // negative for holes
+    Vector2d min, max;
+    std::vector<size_t> holes;
+  };
+
+  std::vector<Contour> contours;
+  VectorOfVector2d vertices;
+  std::vector<size_t> outers;
+  for (const auto& outline : polygon.outlines()) {
+    if (outline.vertices.size() < 3) return false;
+    Contour contour{&outline.vertices, static_cast<int>(vertices.size()), signedArea(outline.vertices),
+                    outline.vertices[0], outline.vertices[0], {}};
+    if (contour.area == 0) return false;
+    for (const auto& v : outline.vertices) {
+      contour.min = contour.min.cwiseMin(v);
+      contour.max = contour.max.cwiseMax(v);
+      vertices.push_back(v);
+    }
+    if (contour.area > 0) outers.push_back(contours.size());
+    contours.push_back(std::move(contour));
+  }
+
+  // A hole belongs to the smallest outline around it. Outlines are only
+  // searched when the bounding boxes don't tell.
+  std::vector<Contour *> candidates;
+  for (size_t h = 0; h < contours.size(); ++h) {
+    if (contours[h].area > 0) continue;
+    const Vector2d& p = (*contours[h].vertices)[0];
+    candidates.clear();
+    for (auto o : outers) {
+      auto& outer = contours[o];
+      if (outer.min[0] <= p[0] && outer.min[1] <= p[1] && outer.max[0] >= p[0] && outer.max[1] >= p[1]) {
+        candidates.push_back(&outer);
+      }
+    }
+    Contour *owner = candidates.size() == 1 ? candidates[0] : nullptr;
+    for (size_t c = 0; candidates.size() > 1 && c < candidates.size(); ++c) {
+      if ((!owner || candidates[c]->area < owner->area) && pointInOutline(p, *candidates[c]->vertices)) {
+        owner = candidates[c];
+      }
+    }
+    if (!owner) return false;
+    owner->holes.push_back(h);
+  }
+
+  const size_t numTriangles = triangles.size();
+  std::vector<bool> used(vertices.size());
+  for (auto o : outers) {
+    const auto& outer = contours[o];
+    const size_t first = triangles.size();
+    Triangulator triangulator(triangles);
+    Node *outerNode = triangulator.addContour(*outer.vertices, outer.first, true);
+    std::vector<Node *> holes;
+    double area = outer.area;
+    for (auto h : outer.holes) {
+      holes.push_back(triangulator.addContour(*contours[h].vertices, contours[h].first, false));
+      area += contours[h].area;
+    }
+    triangulator.triangulate(outerNode, holes);
+
+    // Heuristics can fail on degenerate contours, leaving parts out or
+    // making triangles overlap, so the triangles must add up to the area.
+    double signedSum = 0;
+    double absSum = 0;
+    for (size_t t = first; t < triangles.size(); ++t) {
+      const auto& tri = triangles[t];
+      const Vector2d& a = vertices[tri[0]];
+      const Vector2d& b = vertices[tri[1]];
+      const Vector2d& c = vertices[tri[2]];
+      const double triArea = ((b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0])) / 2;
+      signedSum += triArea;
+      absSum += std::abs(triArea);
+      for (int i = 0; i < 3; ++i) used[tri[i]] = true;
+    }
+    const double tolerance = 1e-9 * outer.area;
+    if (std::abs(signedSum - area) > tolerance || std::abs(absSum - area) > tolerance) {
+      triangles.resize(numTriangles);
+      return false;
+    }
+  }
+
+  // Dropping a vertex which is not a duplicate, such as one in the middle of
+  // a straight edge, would leave a gap next to faces using it.
+  for (const auto& contour : contours) {
+    const auto& v = *contour.vertices;
+    for (size_t i = 0; i < v.size(); ++i) {
+      const size_t next = (i + 1) % v.size();
+      const size_t prev = (i + v.size() - 1) % v.size();
+      if (used[contour.first + i]) continue;
+      if (!(v[i] == v[next] && used[contour.first + next]) && !(v[i] == v[prev] && used[contour.first + prev])) {
+        triangles.resize(numTriangles);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace EarClipping
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "GeometryUtils.h"
+
+class Polygon2d;
+
+/*!
+   Triangulation of sanitized polygons by ear clipping.
+
+   Holes are joined to the outline around them by bridge edges, which turns
+   each outline and its holes into a single simple contour. Ears are then cut
+   off that contour, looking up the vertices which could make a corner a
+   non-ear in a z-order curve for big contours.
+
+   Inputs the heuristics can't handle, such as self-touching or intersecting
+   contours, are reported as failures so the caller can fall back to a
+   constrained Delaunay triangulation.
+ */
+namespace EarClipping {
+
+// Triangulates polygon, appending counter-clockwise triangles to triangles.
+// Vertices are numbered in the order of the outlines and their vertices.
+// Returns false and leaves triangles untouched if the triangles don't cover
+// the polygon exactly.
+bool triangulate(const Polygon2d& polygon, std::vector<IndexedTriangle>& triangles);
+
+} // namespace EarClipping
@@ -3,6 +3,29 @@
 #include <boost/foreach.hpp>
 #include <utility>
 
+namespace {
+
+struct GeometryKindVisitor : public GeometryVisitor
+{
+  void visit(const GeometryList& /*node*/) override { kind = "GeometryList"; }
+  void visit(const PolySet& /*node*/) override { kind = "PolySet"; }
+  void visit(const Polygon2d& /*node*/) override { kind = "Polygon2d"; }
+#ifdef ENABLE_CGAL
+  void visit(const CGAL_Nef_polyhedron& /*node*/) override { kind = "CGAL_Nef_polyhedron"; }
+  void visit(const CGALHybridPolyhedron& /*node*/) override { kind = "CGALHybridPolyhedron"; }
+#endif
+  std::string kind;
+};
+
+} // namespace
+
+std::string geometryKind(const Geometry& geom)
+{
+  GeometryKindVisitor visitor;
+  geom.accept(visitor);
+  return visitor.kind;
+}
+
 GeometryList::GeometryList(Geometry::Geometries geometries) : children(std::move(geometries))
 {
 }
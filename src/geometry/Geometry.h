@@ -65,6 +65,9 @@ public:
   virtual ~GeometryVisitor() = default;
 };
 
+// Name of the class of geom, such as "PolySet", for statistics.
+std::string geometryKind(const Geometry& geom);
+
 #define VISITABLE_GEOMETRY() \
         void accept(GeometryVisitor &visitor) const override { \
           visitor.visit(*this); \
@@ -1,5 +1,6 @@
 #include "GeometryCache.h"
 #include "printutils.h"
+#include "Trace.h"
 #include "Geometry.h"
 
 #ifdef DEBUG
@@ -14,6 +15,7 @@ GeometryCache *GeometryCache::inst = nullptr;
 shared_ptr<const Geometry> GeometryCache::get(const std::string& id) const
 {
   const auto& geom = this->cache[id]->geom;
+  Trace::instant("cache", "GeometryCache hit", "id", id);
 #ifdef DEBUG
   PRINTDB("Geometry Cache hit: %s (%d bytes)", id.substr(0, 40) % (geom ? geom->memsize() : 0));
 #endif
@@ -23,6 +25,7 @@ shared_ptr<const Geometry> GeometryCache::get(const std::string& id) const
 bool GeometryCache::insert(const std::string& id, const shared_ptr<const Geometry>& geom)
 {
   auto inserted = this->cache.insert(id, new cache_entry(geom), geom ? geom->memsize() : 0);
+  Trace::instant("cache", inserted ? "GeometryCache insert" : "GeometryCache insert failed", "id", id);
 #ifdef DEBUG
   assert(!dynamic_cast<const CGAL_Nef_polyhedron *>(geom.get()));
   if (inserted) PRINTDB("Geometry Cache insert: %s (%d bytes)",
@@ -43,6 +46,17 @@ size_t GeometryCache::totalCost() const
   return cache.totalCost();
 }
 
+std::map<std::string, CacheUsage> GeometryCache::usageByKind() const
+{
+  std::map<std::string, CacheUsage> usage;
+  this->cache.forEach([&](const std::string& /*id*/, const cache_entry& entry, size_t cost) {
+    auto& kind = usage[entry.geom ? geometryKind(*entry.geom) : "empty"];
+    kind.entries++;
+    kind.cost += cost;
+  });
+  return usage;
+}
+
 size_t GeometryCache::maxSizeMB() const
 {
   return this->cache.maxCost() / (1024ul * 1024ul);
@@ -57,6 +71,9 @@ void GeometryCache::print()
 {
   LOG(message_group::None, Location::NONE, "", "Geometries in cache: %1$d", this->cache.size());
   LOG(message_group::None, Location::NONE, "", "Geometry cache size in bytes: %1$d", this->cache.totalCost());
+  for (const auto& [kind, usage] : usageByKind()) {
+    LOG(message_group::None, Location::NONE, "", "   %1$s: %2$d entries, %3$d bytes", kind, usage.entries, usage.cost);
+  }
 }
 
 GeometryCache::cache_entry::cache_entry(const shared_ptr<const Geometry>& geom)
@@ -4,6 +4,8 @@
 #include "memory.h"
 #include "Geometry.h"
 
+#include <map>
+
 class GeometryCache
 {
 public:
@@ -16,6 +18,8 @@ public:
   bool insert(const std::string& id, const shared_ptr<const Geometry>& geom);
   size_t size() const;
   size_t totalCost() const;
+  // Entries and their cost by kind of geometry
+  std::map<std::string, CacheUsage> usageByKind() const;
   size_t maxSizeMB() const;
   void setMaxSizeMB(size_t limit);
   void clear() { cache.clear(); }
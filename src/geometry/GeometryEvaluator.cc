@@ -29,7 +29,12 @@
 #include "degree_trig.h"
 #include <ciso646> // C alternative tokens (xor)
 #include <algorithm>
+#include <memory>
+#include <unordered_map>
 #include "boost-utils.h"
+#include "hash.h"
+#include "Trace.h"
+#include "parallel.h"
 
 #include <CGAL/convex_hull_2.h>
 #include <CGAL/Point_2.h>
@@ -46,6 +51,7 @@ GeometryEvaluator::GeometryEvaluator(const Tree& tree) : tree(tree) { }
 shared_ptr<const Geometry> GeometryEvaluator::evaluateGeometry(const AbstractNode& node,
                                                                bool allownef)
 {
+  Trace::Span span("geometry", "evaluateGeometry");
   const std::string& key = this->tree.getIdString(node);
   if (!GeometryCache::instance()->contains(key)) {
     shared_ptr<const Geometry> N;
@@ -234,7 +240,7 @@ Geometry *GeometryEvaluator::applyHull3D(const AbstractNode& node)
 {
   Geometry::Geometries children = collectChildren3D(node);
 
-  auto *P = new PolySet(3);
+  auto *P = new PolySet(3, /* convex */ true);
   if (CGALUtils::applyHull(children, *P)) {
     return P;
   }
@@ -317,6 +323,22 @@ bool GeometryEvaluator::isSmartCached(const AbstractNode& node)
           CGALCache::instance()->contains(key));
 }
 
+/*!
+   Traces the evaluation of a node for --trace-file, noting its source
+   location and whether its geometry was found in a cache.
+ */
+void GeometryEvaluator::traceVisit(Trace::Span& span, const AbstractNode& node)
+{
+  if (!Trace::enabled()) return;
+  span.start("geometry", node.name());
+  if (node.modinst && !node.modinst->location().isNone()) {
+    const Location& loc = node.modinst->location();
+    span.arg("file", boostfs_uncomplete(loc.filePath(), this->tree.getDocumentPath()).generic_string());
+    span.arg("line", static_cast<size_t>(loc.firstLine()));
+  }
+  span.arg("cache", isSmartCached(node) ? "hit" : "miss");
+}
+
 shared_ptr<const Geometry> GeometryEvaluator::smartCacheGet(const AbstractNode& node, bool preferNef)
 {
   const std::string& key = this->tree.getIdString(node);
@@ -401,6 +423,9 @@ Polygon2d *GeometryEvaluator::applyToChildren2D(const AbstractNode& node, OpenSC
     break;
   }
 
+  if (Feature::ExperimentalParallel2dCsg.is_enabled()) {
+    return ClipperUtils::applyBatched(children, clipType);
+  }
   return ClipperUtils::apply(children, clipType);
 }
 
@@ -437,6 +462,8 @@ Response GeometryEvaluator::visit(State& state, const AbstractNode& node)
     state.setPreferNef(true); // Improve quality of CSG by avoiding conversion loss
   }
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       geom = applyToChildren(node, OpenSCADOperator::UNION).constptr();
@@ -460,6 +487,8 @@ Response GeometryEvaluator::visit(State& state, const ListNode& node)
       return Response::PruneTraversal;
     }
     if (state.isPostfix()) {
+      Trace::Span span;
+      traceVisit(span, node);
       unsigned int dim = 0;
       for (const auto& item : this->visitedchildren[node.index()]) {
         if (!isValidDim(item, dim)) break;
@@ -494,6 +523,8 @@ Response GeometryEvaluator::lazyEvaluateRootNode(State& state, const AbstractNod
     }
   }
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
 
     unsigned int dim = 0;
@@ -539,6 +570,8 @@ Response GeometryEvaluator::visit(State& state, const OffsetNode& node)
 {
   if (state.isPrefix() && isSmartCached(node)) return Response::PruneTraversal;
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       const Geometry *geometry = applyToChildren2D(node, OpenSCADOperator::UNION);
@@ -572,6 +605,8 @@ Response GeometryEvaluator::visit(State& state, const RenderNode& node)
     state.setPreferNef(true); // Improve quality of CSG by avoiding conversion loss
   }
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       ResultObject res = applyToChildren(node, OpenSCADOperator::UNION);
@@ -596,6 +631,8 @@ Response GeometryEvaluator::visit(State& state, const RenderNode& node)
 Response GeometryEvaluator::visit(State& state, const LeafNode& node)
 {
   if (state.isPrefix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       const Geometry *geometry = node.createGeometry();
@@ -618,6 +655,8 @@ Response GeometryEvaluator::visit(State& state, const LeafNode& node)
 Response GeometryEvaluator::visit(State& state, const TextNode& node)
 {
   if (state.isPrefix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       std::vector<const Geometry *> geometrylist = node.createGeometryList();
@@ -649,6 +688,8 @@ Response GeometryEvaluator::visit(State& state, const CsgOpNode& node)
     state.setPreferNef(true); // Improve quality of CSG by avoiding conversion loss
   }
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       geom = applyToChildren(node, node.type).constptr();
@@ -672,6 +713,8 @@ Response GeometryEvaluator::visit(State& state, const TransformNode& node)
 {
   if (state.isPrefix() && isSmartCached(node)) return Response::PruneTraversal;
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       if (matrix_contains_infinity(node.matrix) || matrix_contains_nan(node.matrix)) {
@@ -718,15 +761,6 @@ Response GeometryEvaluator::visit(State& state, const TransformNode& node)
   return Response::ContinueTraversal;
 }
 
-static void translate_PolySet(PolySet& ps, const Vector3d& translation)
-{
-  for (auto& p : ps.polygons) {
-    for (auto& v : p) {
-      v += translation;
-    }
-  }
-}
-
 /*
    Compare Euclidean length of vectors
    Return:
@@ -752,6 +786,40 @@ int sgn_vdiff(const Vector2d& v1, const Vector2d& v2) {
  */
 //#define LINEXT_4WAY
 
+/*
+   The vertices of all outlines of a linear_extrude at one height. Each ring is
+   added to the PolySet once, and shared by the slices above and below it.
+ */
+struct ExtrudeRing {
+  double rot;
+  Vector2d scale;
+  double height;
+  Eigen::Matrix2d linear; // the transform of the outlines at this height
+  Eigen::Matrix2Xd points; // transformed vertices of all outlines, in order
+  int first; // index of the first point in the PolySet
+};
+
+static ExtrudeRing add_ring(PolySet *ps, const Eigen::Matrix2Xd& vertices,
+                            double rot, const Vector2d& scale, double height)
+{
+  ExtrudeRing ring{rot, scale, height, {}, {}, static_cast<int>(ps->polygons.vertices.size())};
+  ring.linear = Eigen::Affine2d(Eigen::Scaling(scale) * Eigen::Affine2d(rotate_degrees(-rot))).linear();
+  // One matrix product for the whole ring, which Eigen vectorizes
+  ring.points.noalias() = ring.linear * vertices;
+  for (Eigen::Index i = 0; i < ring.points.cols(); ++i) {
+    ps->add_vertex(Vector3d(ring.points(0, i), ring.points(1, i), height));
+  }
+  return ring;
+}
+
+static void append_triangle(PolySet *ps, int a, int b, int c)
+{
+  ps->append_poly();
+  ps->append_index(a);
+  ps->append_index(b);
+  ps->append_index(c);
+}
+
 /*
    Attempt to triangulate quads in an ideal way.
    Each quad is composed of two adjacent outline vertices: (prev1, curr1)
@@ -760,26 +828,27 @@ int sgn_vdiff(const Vector2d& v1, const Vector2d& v2) {
    However, when diagonals are equal length, decision may flip depending on other factors.
  */
 static void add_slice(PolySet *ps, const Polygon2d& poly,
-                      double rot1, double rot2,
-                      double h1, double h2,
-                      const Vector2d& scale1,
-                      const Vector2d& scale2)
+                      const ExtrudeRing& ring1, const ExtrudeRing& ring2)
 {
-  Eigen::Affine2d trans1(Eigen::Scaling(scale1) * Eigen::Affine2d(rotate_degrees(-rot1)));
-  Eigen::Affine2d trans2(Eigen::Scaling(scale2) * Eigen::Affine2d(rotate_degrees(-rot2)));
+  const Vector2d& scale2 = ring2.scale;
 #ifdef LINEXT_4WAY
-  Eigen::Affine2d trans_mid(Eigen::Scaling((scale1 + scale2) / 2) * Eigen::Affine2d(rotate_degrees(-(rot1 + rot2) / 2)));
-  bool is_straight = rot1 == rot2 && scale1[0] == scale1[1] && scale2[0] == scale2[1];
+  const Vector2d& scale1 = ring1.scale;
+  Eigen::Affine2d trans_mid(Eigen::Scaling((scale1 + scale2) / 2) * Eigen::Affine2d(rotate_degrees(-(ring1.rot + ring2.rot) / 2)));
+  bool is_straight = ring1.rot == ring2.rot && scale1[0] == scale1[1] && scale2[0] == scale2[1];
 #endif
   bool any_zero = scale2[0] == 0 || scale2[1] == 0;
   bool any_non_zero = scale2[0] != 0 || scale2[1] != 0;
   // Not likely to matter, but when no twist (rot2 == rot1),
   // setting back_twist true helps keep diagonals same as previous builds.
-  bool back_twist = rot2 <= rot1;
+  bool back_twist = ring2.rot <= ring1.rot;
 
+  Eigen::Index start = 0; // position of the outline in the rings
   for (const auto& o : poly.outlines()) {
-    Vector2d prev1 = trans1 * o.vertices[0];
-    Vector2d prev2 = trans2 * o.vertices[0];
+    const auto n = static_cast<Eigen::Index>(o.vertices.size());
+    int prev1 = ring1.first + start;
+    int prev2 = ring2.first + start;
+    Vector2d prev1v = ring1.points.col(start);
+    Vector2d prev2v = ring2.points.col(start);
 
     // For equal length diagonals, flip selected choice depending on direction of twist and
     // whether the outline is negative (eg circle hole inside a larger circle).
@@ -788,65 +857,69 @@ static void add_slice(PolySet *ps, const Polygon2d& poly,
     // matched the direction of diagonal for neighboring edges (which did not exhibit "equal" diagonals).
     bool flip = ((!o.positive) xor (back_twist));
 
-    for (size_t i = 1; i <= o.vertices.size(); ++i) {
-      Vector2d curr1 = trans1 * o.vertices[i % o.vertices.size()];
-      Vector2d curr2 = trans2 * o.vertices[i % o.vertices.size()];
+    for (Eigen::Index i = 1; i <= n; ++i) {
+      const Eigen::Index k = start + i % n;
+      int curr1 = ring1.first + k;
+      int curr2 = ring2.first + k;
+      Vector2d curr1v = ring1.points.col(k);
+      Vector2d curr2v = ring2.points.col(k);
 
-      int diff_sign = sgn_vdiff(prev1 - curr2, curr1 - prev2);
+      int diff_sign = sgn_vdiff(prev1v - curr2v, curr1v - prev2v);
       bool splitfirst = diff_sign == -1 || (diff_sign == 0 && !flip);
 
 #ifdef LINEXT_4WAY
       // Diagonals should be equal whenever an edge is co-linear with the origin (edge itself need not touch it)
       if (!is_straight && diff_sign == 0) {
         // Split into 4 triangles, with an added midpoint.
-        //Vector2d mid_prev = trans3 * (prev1 +curr1+curr2)/4;
-        Vector2d mid = trans_mid * (o.vertices[(i - 1) % o.vertices.size()] + o.vertices[i % o.vertices.size()]) / 2;
-        double h_mid = (h1 + h2) / 2;
-        ps->append_poly();
-        ps->insert_vertex(prev1[0], prev1[1], h1);
-        ps->insert_vertex(mid[0],   mid[1], h_mid);
-        ps->insert_vertex(curr1[0], curr1[1], h1);
-        ps->append_poly();
-        ps->insert_vertex(curr1[0], curr1[1], h1);
-        ps->insert_vertex(mid[0],   mid[1], h_mid);
-        ps->insert_vertex(curr2[0], curr2[1], h2);
-        ps->append_poly();
-        ps->insert_vertex(curr2[0], curr2[1], h2);
-        ps->insert_vertex(mid[0],   mid[1], h_mid);
-        ps->insert_vertex(prev2[0], prev2[1], h2);
-        ps->append_poly();
-        ps->insert_vertex(prev2[0], prev2[1], h2);
-        ps->insert_vertex(mid[0],   mid[1], h_mid);
-        ps->insert_vertex(prev1[0], prev1[1], h1);
+        Vector2d mid = trans_mid * (o.vertices[(i - 1) % n] + o.vertices[i % n]) / 2;
+        int midIndex = ps->add_vertex(Vector3d(mid[0], mid[1], (ring1.height + ring2.height) / 2));
+        append_triangle(ps, curr1, midIndex, prev1);
+        append_triangle(ps, curr2, midIndex, curr1);
+        append_triangle(ps, prev2, midIndex, curr2);
+        append_triangle(ps, prev1, midIndex, prev2);
       } else
 #endif // ifdef LINEXT_4WAY
       // Split along shortest diagonal,
       // unless at top for a 0-scaled axis (which can create 0 thickness "ears")
       if (splitfirst xor any_zero) {
-        ps->append_poly();
-        ps->insert_vertex(prev1[0], prev1[1], h1);
-        ps->insert_vertex(curr2[0], curr2[1], h2);
-        ps->insert_vertex(curr1[0], curr1[1], h1);
-        if (!any_zero || (any_non_zero && prev2 != curr2)) {
-          ps->append_poly();
-          ps->insert_vertex(curr2[0], curr2[1], h2);
-          ps->insert_vertex(prev1[0], prev1[1], h1);
-          ps->insert_vertex(prev2[0], prev2[1], h2);
+        append_triangle(ps, curr1, curr2, prev1);
+        if (!any_zero || (any_non_zero && prev2v != curr2v)) {
+          append_triangle(ps, prev2, prev1, curr2);
         }
       } else {
-        ps->append_poly();
-        ps->insert_vertex(prev1[0], prev1[1], h1);
-        ps->insert_vertex(prev2[0], prev2[1], h2);
-        ps->insert_vertex(curr1[0], curr1[1], h1);
-        if (!any_zero || (any_non_zero && prev2 != curr2)) {
-          ps->append_poly();
-          ps->insert_vertex(prev2[0], prev2[1], h2);
-          ps->insert_vertex(curr2[0], curr2[1], h2);
-          ps->insert_vertex(curr1[0], curr1[1], h1);
+        append_triangle(ps, curr1, prev2, prev1);
+        if (!any_zero || (any_non_zero && prev2v != curr2v)) {
+          append_triangle(ps, curr1, curr2, prev2);
         }
       }
       prev1 = curr1;
       prev2 = curr2;
+      prev1v = curr1v;
+      prev2v = curr2v;
+    }
+    start += n;
+  }
+}
+
+/*
+   Adds the triangles of a tessellated cap, mapping its corners to the vertices
+   of a ring. outlineIndex maps outline vertices to their position in the ring.
+ */
+static void add_cap(PolySet *ps, const PolySet& cap, const std::unordered_map<Vector3d, int>& outlineIndex,
+                    const ExtrudeRing& ring, bool reverse)
+{
+  for (const auto& triangle : cap.polygons) {
+    ps->append_poly();
+    for (size_t i = 0; i < triangle.size(); ++i) {
+      const auto& v = triangle[reverse ? triangle.size() - 1 - i : i];
+      auto it = outlineIndex.find(Vector3d(v[0], v[1], 0));
+      if (it != outlineIndex.end()) {
+        ps->append_index(ring.first + it->second);
+      } else {
+        // Tessellation added a vertex
+        Vector2d p = ring.linear * Vector2d(v[0], v[1]);
+        ps->append_index(ps->add_vertex(Vector3d(p[0], p[1], ring.height)));
+      }
     }
   }
 }
@@ -1119,40 +1192,52 @@ static Geometry *extrudePolygon(const LinearExtrudeNode& node, const Polygon2d&
     h2 = node.height;
   }
 
-  // Create bottom face.
-  PolySet *ps_bottom = polyref.tessellate(); // bottom
-  // Flip vertex ordering for bottom polygon
-  for (auto& p : ps_bottom->polygons) {
-    std::reverse(p.begin(), p.end());
+  // Gather all outline vertices, to transform them for each ring at once.
+  size_t numVertices = 0;
+  for (const auto& o : polyref.outlines()) numVertices += o.vertices.size();
+  Eigen::Matrix2Xd vertices(2, numVertices);
+  std::unordered_map<Vector3d, int> outlineIndex;
+  outlineIndex.reserve(numVertices);
+  {
+    Eigen::Index i = 0;
+    for (const auto& o : polyref.outlines()) {
+      for (const auto& v : o.vertices) {
+        vertices.col(i) = v;
+        outlineIndex.emplace(Vector3d(v[0], v[1], 0), i);
+        ++i;
+      }
+    }
   }
-  translate_PolySet(*ps_bottom, Vector3d(0, 0, h1));
-  ps->append(*ps_bottom);
-  delete ps_bottom;
+
+  // The caps are tessellated once, and their triangles used for both ends.
+  std::unique_ptr<PolySet> cap(polyref.tessellate());
+  const bool has_top = node.scale_x != 0 && node.scale_y != 0;
+  const size_t numCapTriangles = cap ? cap->polygons.size() * (has_top ? 2 : 1) : 0;
+  ps->reserve(2 * numVertices * slices + numCapTriangles, 3 * (2 * numVertices * slices + numCapTriangles));
+  ps->polygons.vertices.reserve(numVertices * (slices + 1));
+
+  // Each ring only needs the one below it.
+  auto ring_at = [&](unsigned int j) {
+      Vector2d scale(1 - (1 - node.scale_x) * j / slices,
+                     1 - (1 - node.scale_y) * j / slices);
+      return add_ring(ps, vertices, node.twist * j / slices, scale, h1 + (h2 - h1) * j / slices);
+    };
+  ExtrudeRing bottom = ring_at(0);
+
+  // Create bottom face, with flipped vertex ordering.
+  if (cap) add_cap(ps, *cap, outlineIndex, bottom, true);
 
   // Create slice sides.
+  ExtrudeRing ring1 = bottom;
   for (unsigned int j = 0; j < slices; j++) {
-    double rot1 = node.twist * j / slices;
-    double rot2 = node.twist * (j + 1) / slices;
-    double height1 = h1 + (h2 - h1) * j / slices;
-    double height2 = h1 + (h2 - h1) * (j + 1) / slices;
-    Vector2d scale1(1 - (1 - node.scale_x) * j / slices,
-                    1 - (1 - node.scale_y) * j / slices);
-    Vector2d scale2(1 - (1 - node.scale_x) * (j + 1) / slices,
-                    1 - (1 - node.scale_y) * (j + 1) / slices);
-    add_slice(ps, polyref, rot1, rot2, height1, height2, scale1, scale2);
+    ExtrudeRing ring2 = ring_at(j + 1);
+    add_slice(ps, polyref, ring1, ring2);
+    ring1 = std::move(ring2);
   }
 
   // Create top face.
   // If either scale components are 0, then top will be zero-area, so skip it.
-  if (node.scale_x != 0 && node.scale_y != 0) {
-    Polygon2d top_poly(polyref);
-    Eigen::Affine2d trans(Eigen::Scaling(node.scale_x, node.scale_y) * Eigen::Affine2d(rotate_degrees(-node.twist)));
-    top_poly.transform(trans);
-    PolySet *ps_top = top_poly.tessellate();
-    translate_PolySet(*ps_top, Vector3d(0, 0, h2));
-    ps->append(*ps_top);
-    delete ps_top;
-  }
+  if (cap && has_top) add_cap(ps, *cap, outlineIndex, ring1, false);
 
   return ps;
 }
@@ -1168,6 +1253,8 @@ Response GeometryEvaluator::visit(State& state, const LinearExtrudeNode& node)
 {
   if (state.isPrefix() && isSmartCached(node)) return Response::PruneTraversal;
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       const Geometry *geometry = nullptr;
@@ -1196,22 +1283,18 @@ Response GeometryEvaluator::visit(State& state, const LinearExtrudeNode& node)
   return Response::ContinueTraversal;
 }
 
-static void fill_ring(std::vector<Vector3d>& ring, const Outline2d& o, double a, bool flip)
+// Writes the profile, rotated to angle a around the Z axis, to the vertex buffer
+// starting at ring. The profile holds the x and y coordinates of all outlines.
+static void fill_ring(std::vector<Vector3d>& vertices, size_t ring, const Eigen::Matrix2Xd& profile, double a)
 {
-  if (flip) {
-    unsigned int l = o.vertices.size() - 1;
-    for (unsigned int i = 0; i < o.vertices.size(); ++i) {
-      ring[i][0] = o.vertices[l - i][0] * sin_degrees(a);
-      ring[i][1] = o.vertices[l - i][0] * cos_degrees(a);
-      ring[i][2] = o.vertices[l - i][1];
-    }
-  } else {
-    for (unsigned int i = 0; i < o.vertices.size(); ++i) {
-      ring[i][0] = o.vertices[i][0] * sin_degrees(a);
-      ring[i][1] = o.vertices[i][0] * cos_degrees(a);
-      ring[i][2] = o.vertices[i][1];
-    }
-  }
+  const double s = sin_degrees(a);
+  const double c = cos_degrees(a);
+  // Vector3d is unaligned in a std::vector, so map it as a 3xN matrix, which
+  // lets Eigen vectorize the products for the whole ring.
+  Eigen::Map<Eigen::Matrix3Xd> out(vertices[ring].data(), 3, profile.cols());
+  out.row(0).noalias() = profile.row(0) * s;
+  out.row(1).noalias() = profile.row(0) * c;
+  out.row(2) = profile.row(1);
 }
 
 /*!
@@ -1258,55 +1341,111 @@ static Geometry *rotatePolygon(const RotateExtrudeNode& node, const Polygon2d& p
 
   bool flip_faces = (min_x >= 0 && node.angle > 0 && node.angle != 360) || (min_x < 0 && (node.angle < 0 || node.angle == 360));
 
-  if (node.angle != 360) {
-    PolySet *ps_start = poly.tessellate(); // starting face
-    Transform3d rot(angle_axis_degrees(90, Vector3d::UnitX()));
-    ps_start->transform(rot);
-    // Flip vertex ordering
-    if (!flip_faces) {
-      for (auto& p : ps_start->polygons) {
-        std::reverse(p.begin(), p.end());
+  // All outlines in one profile, each reversed when flipping faces, and where
+  // each outline vertex is in it.
+  size_t numVertices = 0;
+  for (const auto& o : poly.outlines()) numVertices += o.vertices.size();
+  Eigen::Matrix2Xd profile(2, numVertices);
+  std::unordered_map<Vector3d, int> profileIndex;
+  profileIndex.reserve(numVertices);
+  {
+    Eigen::Index k = 0;
+    for (const auto& o : poly.outlines()) {
+      const size_t l = o.vertices.size() - 1;
+      for (size_t i = 0; i < o.vertices.size(); ++i, ++k) {
+        const auto& v = o.vertices[flip_faces ? l - i : i];
+        profile.col(k) = v;
+        profileIndex.emplace(Vector3d(v[0], v[1], 0), k);
       }
     }
-    ps->append(*ps_start);
-    delete ps_start;
-
-    PolySet *ps_end = poly.tessellate();
-    Transform3d rot2(angle_axis_degrees(node.angle, Vector3d::UnitZ()) * angle_axis_degrees(90, Vector3d::UnitX()));
-    ps_end->transform(rot2);
-    if (flip_faces) {
-      for (auto& p : ps_end->polygons) {
-        std::reverse(p.begin(), p.end());
+  }
+
+  // A full revolve ends on its first ring.
+  const size_t numRings = node.angle == 360 ? fragments : fragments + 1;
+  auto ring_angle = [&](size_t r) {
+      if (node.angle == 360) return -90 + r * 360.0 / fragments; // start on the -X axis, for legacy support
+      else return 90 - r * node.angle / fragments; // start on the X axis
+    };
+
+  std::unique_ptr<PolySet> cap;
+  if (node.angle != 360) cap.reset(poly.tessellate());
+  const size_t numCapTriangles = cap ? cap->polygons.size() : 0;
+  const size_t numTriangles = 2 * numCapTriangles + 2 * numVertices * fragments;
+
+  // The mesh is written in place, so slices of the revolve can be filled on
+  // separate threads.
+  auto& polygons = ps->polygons;
+  polygons.vertices.resize(numRings * numVertices);
+  polygons.indices.resize(3 * numTriangles);
+  polygons.offsets.resize(numTriangles + 1);
+  for (size_t t = 0; t <= numTriangles; ++t) polygons.offsets[t] = 3 * t;
+
+  auto set_triangle = [&](size_t t, int a, int b, int c) {
+      polygons.indices[3 * t] = a;
+      polygons.indices[3 * t + 1] = b;
+      polygons.indices[3 * t + 2] = c;
+    };
+
+  // Caps come first: the starting face on the first ring and the end face on
+  // the last one.
+  if (cap) {
+    for (int end = 0; end < 2; ++end) {
+      const size_t ring = end ? numRings - 1 : 0;
+      const bool reverse = end ? flip_faces : !flip_faces;
+      for (size_t t = 0; t < numCapTriangles; ++t) {
+        const auto& triangle = cap->polygons[t];
+        int corners[3];
+        for (size_t i = 0; i < 3; ++i) {
+          const auto& v = triangle[reverse ? 2 - i : i];
+          auto it = profileIndex.find(Vector3d(v[0], v[1], 0));
+          if (it != profileIndex.end()) {
+            corners[i] = ring * numVertices + it->second;
+          } else {
+            // Tessellation added a vertex
+            const double a = ring_angle(ring);
+            corners[i] = polygons.addVertex(Vector3d(v[0] * sin_degrees(a), v[0] * cos_degrees(a), v[1]));
+          }
+        }
+        set_triangle(end * numCapTriangles + t, corners[0], corners[1], corners[2]);
       }
     }
-    ps->append(*ps_end);
-    delete ps_end;
   }
 
-  for (const auto& o : poly.outlines()) {
-    std::vector<Vector3d> rings[2];
-    rings[0].resize(o.vertices.size());
-    rings[1].resize(o.vertices.size());
-
-    fill_ring(rings[0], o, (node.angle == 360) ? -90 : 90, flip_faces); // first ring
-    for (unsigned int j = 0; j < fragments; ++j) {
-      double a;
-      if (node.angle == 360) a = -90 + ((j + 1) % fragments) * 360.0 / fragments; // start on the -X axis, for legacy support
-      else a = 90 - (j + 1) * node.angle / fragments; // start on the X axis
-      fill_ring(rings[(j + 1) % 2], o, a, flip_faces);
-
-      for (size_t i = 0; i < o.vertices.size(); ++i) {
-        ps->append_poly();
-        ps->insert_vertex(rings[j % 2][i]);
-        ps->insert_vertex(rings[(j + 1) % 2][(i + 1) % o.vertices.size()]);
-        ps->insert_vertex(rings[j % 2][(i + 1) % o.vertices.size()]);
-        ps->append_poly();
-        ps->insert_vertex(rings[j % 2][i]);
-        ps->insert_vertex(rings[(j + 1) % 2][i]);
-        ps->insert_vertex(rings[(j + 1) % 2][(i + 1) % o.vertices.size()]);
+  // Fills the fragments in [begin, end), and the rings they start on.
+  auto fill_fragments = [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; ++r) fill_ring(polygons.vertices, r * numVertices, profile, ring_angle(r));
+      if (end == fragments && numRings > fragments) {
+        fill_ring(polygons.vertices, fragments * numVertices, profile, ring_angle(fragments));
       }
-    }
+      size_t start = 0; // position of the outline in the profile
+      for (const auto& o : poly.outlines()) {
+        const size_t n = o.vertices.size();
+        for (size_t j = begin; j < end; ++j) {
+          const size_t ring1 = j * numVertices + start;
+          const size_t ring2 = ((j + 1) % numRings) * numVertices + start;
+          size_t t = 2 * numCapTriangles + 2 * (start * fragments + j * n);
+          for (size_t i = 0; i < n; ++i, t += 2) {
+            const size_t next = (i + 1) % n;
+            set_triangle(t, ring1 + next, ring2 + next, ring1 + i);
+            set_triangle(t + 1, ring2 + next, ring2 + i, ring1 + i);
+          }
+        }
+        start += n;
+      }
+    };
+
+  // Below this, starting threads costs more than it saves.
+  constexpr size_t minQuadsPerThread = 100000;
+  const size_t numThreads = !Feature::ExperimentalParallelExtrude.is_enabled() || Parallel::isWorker() ? 1 :
+                            std::min<size_t>({Parallel::concurrency(), fragments, numVertices * fragments / minQuadsPerThread});
+  if (numThreads > 1) {
+    Parallel::run(numThreads, [&](size_t thread) {
+      fill_fragments(fragments * thread / numThreads, fragments * (thread + 1) / numThreads);
+    });
+  } else {
+    fill_fragments(0, fragments);
   }
+  ps->setDirty();
 
   return ps;
 }
@@ -1322,6 +1461,8 @@ Response GeometryEvaluator::visit(State& state, const RotateExtrudeNode& node)
 {
   if (state.isPrefix() && isSmartCached(node)) return Response::PruneTraversal;
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       const Geometry *geometry = nullptr;
@@ -1359,6 +1500,30 @@ Response GeometryEvaluator::visit(State& /*state*/, const AbstractPolyNode& /*no
 
 shared_ptr<const Geometry> GeometryEvaluator::projectionCut(const ProjectionNode& node)
 {
+  if (Feature::ExperimentalFastProjectionCut.is_enabled()) {
+    // Slice the meshes of the children directly, which needs neither their
+    // union in 3D nor Nef polyhedra.
+    std::vector<std::unique_ptr<const Polygon2d>> slices;
+    bool sliced = true;
+    for (const auto& item : collectChildren3D(node)) {
+      if (!item.second || item.second->isEmpty()) continue;
+      auto chPS = CGALUtils::getGeometryAsPolySet(item.second);
+      std::unique_ptr<const Polygon2d> slice(chPS ? PolySetUtils::slice(*chPS) : nullptr);
+      if (!slice) {
+        sliced = false;
+        break;
+      }
+      slices.push_back(std::move(slice));
+    }
+    if (sliced && !slices.empty()) {
+      std::vector<const Polygon2d *> polygons;
+      for (const auto& slice : slices) polygons.push_back(slice.get());
+      auto poly = ClipperUtils::apply(polygons, ClipperLib::ctUnion);
+      poly->setConvexity(node.convexity);
+      return shared_ptr<const Geometry>(poly);
+    }
+  }
+
   shared_ptr<const Geometry> geom;
   shared_ptr<const Geometry> newgeom = applyToChildren3D(node, OpenSCADOperator::UNION).constptr();
   if (newgeom) {
@@ -1376,6 +1541,7 @@ shared_ptr<const Geometry> GeometryEvaluator::projectionCut(const ProjectionNode
 
 shared_ptr<const Geometry> GeometryEvaluator::projectionNoCut(const ProjectionNode& node)
 {
+  const bool parallel = Feature::ExperimentalParallelProjection.is_enabled();
   shared_ptr<const Geometry> geom;
   std::vector<const Polygon2d *> tmp_geom;
   BoundingBox bounds;
@@ -1391,7 +1557,7 @@ shared_ptr<const Geometry> GeometryEvaluator::projectionNoCut(const ProjectionNo
     // It's better in V6 but not quite there. FIXME: stand-alone example.
     // project chgeom -> polygon2d
     auto chPS = CGALUtils::getGeometryAsPolySet(chgeom);
-    if (chPS) poly = PolySetUtils::project(*chPS);
+    if (chPS) poly = parallel ? PolySetUtils::projectFrontFaces(*chPS) : PolySetUtils::project(*chPS);
 
     if (poly) {
       bounds.extend(poly->getBoundingBox());
@@ -1406,7 +1572,8 @@ shared_ptr<const Geometry> GeometryEvaluator::projectionNoCut(const ProjectionNo
     ClipperLib::Paths result = ClipperUtils::fromPolygon2d(*poly, pow2);
     // Using NonZero ensures that we don't create holes from polygons sharing
     // edges since we're unioning a mesh
-    result = ClipperUtils::process(result, ClipperLib::ctUnion, ClipperLib::pftNonZero);
+    result = parallel ? ClipperUtils::unionTiles(result, ClipperLib::pftNonZero)
+      : ClipperUtils::process(result, ClipperLib::ctUnion, ClipperLib::pftNonZero);
     // Add correctly winded polygons to the main clipper
     sumclipper.AddPaths(result, ClipperLib::ptSubject, true);
     delete poly;
@@ -1435,6 +1602,8 @@ Response GeometryEvaluator::visit(State& state, const ProjectionNode& node)
 {
   if (state.isPrefix() && isSmartCached(node)) return Response::PruneTraversal;
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (isSmartCached(node)) {
       geom = smartCacheGet(node, false);
@@ -1461,6 +1630,8 @@ Response GeometryEvaluator::visit(State& state, const CgalAdvNode& node)
 {
   if (state.isPrefix() && isSmartCached(node)) return Response::PruneTraversal;
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       switch (node.type) {
@@ -1515,6 +1686,8 @@ Response GeometryEvaluator::visit(State& state, const AbstractIntersectionNode&
     state.setPreferNef(true); // Improve quality of CSG by avoiding conversion loss
   }
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       geom = applyToChildren(node, OpenSCADOperator::INTERSECTION).constptr();
@@ -1547,6 +1720,8 @@ Response GeometryEvaluator::visit(State& state, const RoofNode& node)
 {
   if (state.isPrefix() && isSmartCached(node)) return Response::PruneTraversal;
   if (state.isPostfix()) {
+    Trace::Span span;
+    traceVisit(span, node);
     shared_ptr<const Geometry> geom;
     if (!isSmartCached(node)) {
       const Geometry *geometry = applyToChildren2D(node, OpenSCADOperator::UNION);
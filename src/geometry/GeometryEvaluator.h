@@ -4,6 +4,7 @@
 #include "enums.h"
 #include "memory.h"
 #include "Geometry.h"
+#include "Trace.h"
 
 #include <utility>
 #include <list>
@@ -70,6 +71,7 @@ private:
   void smartCacheInsert(const AbstractNode& node, const shared_ptr<const Geometry>& geom);
   shared_ptr<const Geometry> smartCacheGet(const AbstractNode& node, bool preferNef);
   bool isSmartCached(const AbstractNode& node);
+  void traceVisit(Trace::Span& span, const AbstractNode& node);
   bool isValidDim(const Geometry::GeometryItem& item, unsigned int& dim) const;
   std::vector<const Polygon2d *> collectChildren2D(const AbstractNode& node);
   Geometry::Geometries collectChildren3D(const AbstractNode& node);
@@ -5,17 +5,73 @@
 #include <unordered_map>
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 
 #include <boost/functional/hash.hpp>
 
-static void *stdAlloc(void *userData, unsigned int size) {
-  TESS_NOTUSED(userData);
-  return malloc(size);
+/*!
+   Memory for libtess2, reused by the tessellations done on the same thread.
+
+   Deleting a tesselator frees all its memory at once, so allocations are
+   carved out of a few blocks, and each tessellation starts over in the blocks
+   of the previous one instead of going through malloc for every bucket.
+ */
+class TessArena
+{
+public:
+  void *allocate(size_t size) {
+    size = (size + alignment - 1) & ~(alignment - 1);
+    while (block < blocks.size() && used + size > blocks[block].size) {
+      ++block;
+      used = 0;
+    }
+    if (block == blocks.size()) {
+      const size_t blockSize = std::max(size, minBlockSize);
+      blocks.push_back({std::make_unique<char[]>(blockSize), blockSize});
+      capacity += blockSize;
+      used = 0;
+    }
+    void *ptr = blocks[block].data.get() + used;
+    used += size;
+    return ptr;
+  }
+
+  // Makes all memory available again. Memory of unusually large
+  // tessellations is given back.
+  void reset() {
+    if (capacity > maxCapacity) {
+      blocks.clear();
+      capacity = 0;
+    }
+    block = 0;
+    used = 0;
+  }
+
+private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+  static constexpr size_t alignment = alignof(std::max_align_t);
+  static constexpr size_t minBlockSize = 256 * 1024;
+  static constexpr size_t maxCapacity = 16 * 1024 * 1024;
+
+  std::vector<Block> blocks;
+  size_t block = 0; // block being allocated from
+  size_t used = 0; // bytes used in it
+  size_t capacity = 0;
+};
+
+static void *arenaAlloc(void *userData, unsigned int size) {
+  return static_cast<TessArena *>(userData)->allocate(size);
 }
 
-static void stdFree(void *userData, void *ptr) {
+static void arenaFree(void *userData, void *ptr) {
+  // Released all at once by TessArena::reset()
   TESS_NOTUSED(userData);
-  free(ptr);
+  TESS_NOTUSED(ptr);
 }
 
 using IndexedEdge = std::pair<int, int>;
@@ -263,12 +319,16 @@ bool GeometryUtils::tessellatePolygonWithHoles(const std::vector<Vector3f>& vert
     normalvec = passednormal;
   }
 
+  thread_local TessArena arena;
+  arena.reset();
+
   TESSalloc ma;
   TESStesselator *tess = nullptr;
 
   memset(&ma, 0, sizeof(ma));
-  ma.memalloc = stdAlloc;
-  ma.memfree = stdFree;
+  ma.memalloc = arenaAlloc;
+  ma.memfree = arenaFree;
+  ma.userData = &arena;
   ma.extraVertices = 256; // realloc not provided, allow 256 extra vertices.
 
   if (!(tess = tessNewTess(&ma))) return true;
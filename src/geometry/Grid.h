@@ -2,12 +2,15 @@
 
 #include "linalg.h"
 #include "hash.h"
-#include <boost/functional/hash.hpp>
+#include "parallel.h"
 #include <cmath>
 
+#include <algorithm>
 #include <cstdint> // int64_t
-#include <unordered_map>
+#include <cstdlib>
+#include <limits>
 #include <utility>
+#include <vector>
 
 //const double GRID_COARSE = 0.001;
 //const double GRID_FINE   = 0.000001;
@@ -19,12 +22,116 @@
 const double GRID_COARSE = 0.0009765625;
 const double GRID_FINE = 0.00000095367431640625;
 
+/*
+   Hashes of grid cells. Models are often aligned to round numbers, which
+   are multiples of a power of two cells, so all bits of the coordinates are
+   mixed into the hash.
+ */
+inline uint64_t gridHash(int64_t x, int64_t y)
+{
+  return hash_mix(uint64_t(x) * 0x9e3779b97f4a7c15ULL + uint64_t(y) * 0xc2b2ae3d27d4eb4fULL);
+}
+
+inline uint64_t gridHash(int64_t x, int64_t y, int64_t z)
+{
+  return hash_mix(uint64_t(x) * 0x9e3779b97f4a7c15ULL + uint64_t(y) * 0xc2b2ae3d27d4eb4fULL +
+                  uint64_t(z) * 0x165667b19e3779f9ULL);
+}
+
+/*!
+   Map from grid cells to data, using open addressing with linear probing.
+
+   Entries are stored densely in insertion order and numbered from 0. The
+   table itself only holds entry numbers and part of their hashes, so probing
+   reads a single array and growing it doesn't move the entries. Inserting may
+   move the data though, so unlike with std::unordered_map, references to it
+   are only valid until the next insertion.
+ */
+template <typename Key, typename T>
+class GridMap
+{
+public:
+  static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+  [[nodiscard]] size_t size() const { return keys.size(); }
+
+  void reserve(size_t n) {
+    keys.reserve(n);
+    values.reserve(n);
+    if (2 * n > slots.size()) rehash(2 * n);
+  }
+
+  // Returns the number of the entry of key, or none.
+  [[nodiscard]] size_t find(const Key& key, uint64_t hash) const {
+    if (slots.empty()) return none;
+    const auto tag = uint32_t(hash >> 32);
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      const Slot& slot = slots[i];
+      if (slot.entry == 0) return none;
+      if (slot.tag == tag && keys[slot.entry - 1] == key) return slot.entry - 1;
+    }
+  }
+
+  // Returns the number of the entry of key, adding it with value initialized
+  // data if there's none.
+  size_t insert(const Key& key, uint64_t hash) {
+    if (2 * (keys.size() + 1) > slots.size()) rehash(std::max<size_t>(16, 2 * slots.size()));
+    const auto tag = uint32_t(hash >> 32);
+    size_t i = hash & mask;
+    for (;; i = (i + 1) & mask) {
+      const Slot& slot = slots[i];
+      if (slot.entry == 0) break;
+      if (slot.tag == tag && keys[slot.entry - 1] == key) return slot.entry - 1;
+    }
+    keys.push_back(key);
+    values.emplace_back();
+    slots[i] = {uint32_t(keys.size()), tag};
+    return keys.size() - 1;
+  }
+
+  [[nodiscard]] const Key& key(size_t entry) const { return keys[entry]; }
+  T& data(size_t entry) { return values[entry]; }
+  [[nodiscard]] const T& data(size_t entry) const { return values[entry]; }
+
+private:
+  struct Slot {
+    uint32_t entry; // entry number + 1, 0 if the slot is free
+    uint32_t tag;   // high bits of the hash of the entry's key
+  };
+
+  // Rebuilds the table with size slots, a power of two.
+  void rehash(size_t size) {
+    size_t n = 16;
+    while (n < size) n *= 2;
+    std::vector<Slot> table(n, Slot{0, 0});
+    mask = n - 1;
+    for (const auto& slot : slots) {
+      if (slot.entry == 0) continue;
+      // Slots only keep the high bits of the hashes, so the low ones are
+      // computed again.
+      size_t i = hashOf(keys[slot.entry - 1]) & mask;
+      while (table[i].entry != 0) i = (i + 1) & mask;
+      table[i] = slot;
+    }
+    slots.swap(table);
+  }
+
+  static uint64_t hashOf(const std::pair<int64_t, int64_t>& key) { return gridHash(key.first, key.second); }
+  static uint64_t hashOf(const Vector3l& key) { return gridHash(key[0], key[1], key[2]); }
+
+  std::vector<Slot> slots;
+  size_t mask = 0;
+  std::vector<Key> keys;
+  std::vector<T> values;
+};
+
 template <typename T>
 class Grid2d
 {
 public:
   double res;
-  std::unordered_map<std::pair<int64_t, int64_t>, T, boost::hash<std::pair<int64_t, int64_t>>> db;
+  using Key = std::pair<int64_t, int64_t>;
+  GridMap<Key, T> db;
 
   Grid2d(double resolution) {
     res = resolution;
@@ -32,36 +139,39 @@ public:
   /*!
      Aligns x,y to the grid or to existing point if one close enough exists.
      Returns the value stored if a point already existing or an uninitialized new value
-     if not.
+     if not. The reference is valid until the next point is added.
    */
   T& align(double& x, double& y) {
     auto ix = (int64_t)std::round(x / res);
     auto iy = (int64_t)std::round(y / res);
-    if (db.find(std::make_pair(ix, iy)) == db.end()) {
+    auto entry = db.find(Key(ix, iy), gridHash(ix, iy));
+    if (entry == db.none) {
+      // Distances are measured from the closest point found so far
       int dist = 10;
       for (int64_t jx = ix - 1; jx <= ix + 1; ++jx) {
         for (int64_t jy = iy - 1; jy <= iy + 1; ++jy) {
-          if (db.find(std::make_pair(jx, jy)) == db.end()) continue;
           int d = abs(int(ix - jx)) + abs(int(iy - jy));
-          if (d < dist) {
-            dist = d;
-            ix = jx;
-            iy = jy;
-          }
+          if (d >= dist) continue;
+          auto neighbor = db.find(Key(jx, jy), gridHash(jx, jy));
+          if (neighbor == db.none) continue;
+          dist = d;
+          ix = jx;
+          iy = jy;
+          entry = neighbor;
         }
       }
+      if (entry == db.none) entry = db.insert(Key(ix, iy), gridHash(ix, iy));
     }
     x = ix * res, y = iy * res;
-    return db[std::make_pair(ix, iy)];
+    return db.data(entry);
   }
 
   [[nodiscard]] bool has(double x, double y) const {
     auto ix = (int64_t)std::round(x / res);
     auto iy = (int64_t)std::round(y / res);
-    if (db.find(std::make_pair(ix, iy)) != db.end()) return true;
     for (int64_t jx = ix - 1; jx <= ix + 1; ++jx)
       for (int64_t jy = iy - 1; jy <= iy + 1; ++jy) {
-        if (db.find(std::make_pair(jx, jy)) != db.end()) return true;
+        if (db.find(Key(jx, jy), gridHash(jx, jy)) != db.none) return true;
       }
     return false;
   }
@@ -86,7 +196,7 @@ class Grid3d
 public:
   double res;
   using Key = Vector3l;
-  using GridContainer = std::unordered_map<Key, T>;
+  using GridContainer = GridMap<Key, T>;
   GridContainer db;
 
   Grid3d(double resolution) {
@@ -104,33 +214,66 @@ public:
   T align(Vector3d& v) {
     Vector3l key;
     createGridVertex(v, key);
-    auto iter = db.find(key);
-    if (iter == db.end()) {
-      float dist = 10.0f; // > max possible distance
-      for (int64_t jx = key[0] - 1; jx <= key[0] + 1; ++jx) {
-        for (int64_t jy = key[1] - 1; jy <= key[1] + 1; ++jy) {
-          for (int64_t jz = key[2] - 1; jz <= key[2] + 1; ++jz) {
-            Vector3l k(jx, jy, jz);
-            auto tmpiter = db.find(k);
-            if (tmpiter == db.end()) continue;
-            float d = sqrt((key - k).squaredNorm());
-            if (d < dist) {
-              dist = d;
-              iter = tmpiter;
-            }
-          }
+    return align(v, key, gridHash(key[0], key[1], key[2]));
+  }
+
+  // Aligns each of vertices like align() does, in order, and returns their
+  // indices. If parallel is set, the grid cells of big arrays are computed on
+  // several threads, while the vertices are added on the calling thread, so
+  // the result doesn't depend on the number of threads.
+  std::vector<T> align(std::vector<Vector3d>& vertices, bool parallel) {
+    std::vector<Vector3l> keys(vertices.size());
+    std::vector<uint64_t> hashes(vertices.size());
+    constexpr size_t minVerticesPerThread = 100000;
+    const size_t numThreads = !parallel || Parallel::isWorker() ? 1 :
+                              std::min<size_t>(Parallel::concurrency(), vertices.size() / minVerticesPerThread);
+    const auto createGridVertices = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          createGridVertex(vertices[i], keys[i]);
+          hashes[i] = gridHash(keys[i][0], keys[i][1], keys[i][2]);
         }
-      }
+      };
+    if (numThreads > 1) {
+      Parallel::run(numThreads, [&](size_t thread) {
+        createGridVertices(vertices.size() * thread / numThreads, vertices.size() * (thread + 1) / numThreads);
+      });
+    } else {
+      createGridVertices(0, vertices.size());
     }
 
+    db.reserve(db.size() + vertices.size());
+    std::vector<T> result(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) result[i] = align(vertices[i], keys[i], hashes[i]);
+    return result;
+  }
+
+  bool has(const Vector3d& v, T *data = nullptr) {
+    Vector3l key;
+    createGridVertex(v, key);
+    auto entry = db.find(key, gridHash(key[0], key[1], key[2]));
+    if (entry == db.none) entry = findNeighbor(key);
+    if (entry == db.none) return false;
+    if (data) *data = db.data(entry);
+    return true;
+  }
+
+  T data(Vector3d v) {
+    return align(v);
+  }
+
+private:
+  T align(Vector3d& v, Vector3l key, uint64_t hash) {
+    auto entry = db.find(key, hash);
+    if (entry == db.none) entry = findNeighbor(key);
+
     T data;
-    if (iter == db.end()) { // Not found: insert using key
+    if (entry == db.none) { // Not found: insert using key
       data = db.size();
-      db[key] = data;
+      db.data(db.insert(key, hash)) = data;
     } else {
       // If found return existing data
-      key = iter->first;
-      data = iter->second;
+      key = db.key(entry);
+      data = db.data(entry);
     }
 
     // Align vertex
@@ -141,27 +284,27 @@ public:
     return data;
   }
 
-  bool has(const Vector3d& v, T *data = nullptr) {
-    Vector3l key = createGridVertex(v);
-    typename GridContainer::iterator pos = db.find(key);
-    if (pos != db.end()) {
-      if (data) *data = pos->second;
-      return true;
+  // Returns the entry closest to cell key among its neighbors, the first one
+  // in x,y,z order on ties, or none.
+  [[nodiscard]] size_t findNeighbor(const Vector3l& key) const {
+    // All hashes are computed before probing, so the probes don't wait on
+    // each other.
+    uint64_t hashes[27];
+    for (int i = 0; i < 27; ++i) {
+      hashes[i] = gridHash(key[0] + i / 9 - 1, key[1] + i / 3 % 3 - 1, key[2] + i % 3 - 1);
     }
-    for (int64_t jx = key[0] - 1; jx <= key[0] + 1; ++jx)
-      for (int64_t jy = key[1] - 1; jy <= key[1] + 1; ++jy)
-        for (int64_t jz = key[2] - 1; jz <= key[2] + 1; ++jz) {
-          pos = db.find(Vector3l(jx, jy, jz));
-          if (pos != db.end()) {
-            if (data) *data = pos->second;
-            return true;
-          }
-        }
-    return false;
-  }
-
-  T data(Vector3d v) {
-    return align(v);
+    size_t result = db.none;
+    int dist = 10; // > max possible squared distance
+    for (int i = 0; i < 27; ++i) {
+      const Vector3l delta(i / 9 - 1, i / 3 % 3 - 1, i % 3 - 1);
+      const int d = delta.squaredNorm();
+      // The cell itself has been looked up already
+      if (d == 0 || d >= dist) continue;
+      const auto entry = db.find(key + delta, hashes[i]);
+      if (entry == db.none) continue;
+      dist = d;
+      result = entry;
+    }
+    return result;
   }
-
 };
@@ -39,10 +39,20 @@
 void IndexedMesh::append_geometry(const PolySet& ps)
 {
   IndexedMesh& mesh = *this;
+  // Look up each PolySet vertex once, however many polygons share it, in
+  // the order polygons first use them
+  std::vector<int> used(ps.polygons.vertices.size(), -1);
+  std::vector<Vector3d> vertices;
+  for (int vertex : ps.polygons.indices) {
+    if (used[vertex] >= 0) continue;
+    used[vertex] = vertices.size();
+    vertices.push_back(ps.polygons.vertices[vertex]);
+  }
+  std::vector<int> lookedUp(vertices.size());
+  mesh.vertices.lookup(vertices.data(), vertices.size(), lookedUp.data());
+
   for (const auto& p : ps.polygons) {
-    for (const auto& v : p) {
-      mesh.indices.push_back(mesh.vertices.lookup(v));
-    }
+    for (size_t i = 0; i < p.size(); ++i) mesh.indices.push_back(lookedUp[used[p.index(i)]]);
     mesh.numfaces++;
     mesh.indices.push_back(-1);
   }
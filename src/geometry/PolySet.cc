@@ -29,7 +29,9 @@
 #include "linalg.h"
 #include "printutils.h"
 #include "Grid.h"
+#include "Feature.h"
 #include <Eigen/LU>
+#include <limits>
 #include <utility>
 
 /*! /class PolySet
@@ -44,6 +46,10 @@
 
    PolySet must only contain convex polygons
 
+   Polygons are stored in a PolygonList, which keeps all vertices in one
+   buffer. Builders which know that polygons share a vertex can say so with
+   add_vertex() and append_index().
+
  */
 
 PolySet::PolySet(unsigned int dim, boost::tribool convex) : dim(dim), convex(convex), dirty(false)
@@ -77,12 +83,12 @@ std::string PolySet::dump() const
 
 void PolySet::append_poly()
 {
-  polygons.push_back(Polygon());
+  polygons.beginPolygon();
 }
 
 void PolySet::append_poly(const Polygon& poly)
 {
-  polygons.push_back(poly);
+  polygons.append(poly);
   this->dirty = true;
 }
 
@@ -93,7 +99,7 @@ void PolySet::append_vertex(double x, double y, double z)
 
 void PolySet::append_vertex(const Vector3d& v)
 {
-  polygons.back().push_back(v);
+  polygons.appendVertex(v);
   this->dirty = true;
 }
 
@@ -109,7 +115,7 @@ void PolySet::insert_vertex(double x, double y, double z)
 
 void PolySet::insert_vertex(const Vector3d& v)
 {
-  polygons.back().insert(polygons.back().begin(), v);
+  polygons.insertVertex(v);
   this->dirty = true;
 }
 
@@ -118,14 +124,24 @@ void PolySet::insert_vertex(const Vector3f& v)
   insert_vertex((const Vector3d&)v.cast<double>());
 }
 
+int PolySet::add_vertex(const Vector3d& v)
+{
+  return polygons.addVertex(v);
+}
+
+void PolySet::append_index(int index)
+{
+  polygons.appendIndex(index);
+  this->dirty = true;
+}
+
 BoundingBox PolySet::getBoundingBox() const
 {
   if (this->dirty) {
     this->bbox.setNull();
-    for (const auto& poly : polygons) {
-      for (const auto& p : poly) {
-        this->bbox.extend(p);
-      }
+    // Only vertices used by a polygon count, as removed polygons leave theirs behind.
+    for (int index : polygons.indices) {
+      this->bbox.extend(polygons.vertices[index]);
     }
     this->dirty = false;
   }
@@ -134,8 +150,7 @@ BoundingBox PolySet::getBoundingBox() const
 
 size_t PolySet::memsize() const
 {
-  size_t mem = 0;
-  for (const auto& p : this->polygons) mem += p.size() * sizeof(Vector3d);
+  size_t mem = this->polygons.memsize();
   mem += this->polygon.memsize() - sizeof(this->polygon);
   mem += sizeof(PolySet);
   return mem;
@@ -143,7 +158,7 @@ size_t PolySet::memsize() const
 
 void PolySet::append(const PolySet& ps)
 {
-  this->polygons.insert(this->polygons.end(), ps.polygons.begin(), ps.polygons.end());
+  this->polygons.append(ps.polygons);
   if (!dirty && !this->bbox.isNull()) {
     this->bbox.extend(ps.getBoundingBox());
   }
@@ -155,11 +170,22 @@ void PolySet::transform(const Transform3d& mat)
   // If mirroring transform, flip faces to avoid the object to end up being inside-out
   bool mirrored = mat.matrix().determinant() < 0;
 
-  for (auto& p : this->polygons) {
-    for (auto& v : p) {
-      v = mat * v;
-    }
-    if (mirrored) std::reverse(p.begin(), p.end());
+  for (auto& v : this->polygons.vertices) {
+    v = mat * v;
+  }
+  if (mirrored) this->polygons.reverseAll();
+  this->dirty = true;
+}
+
+void PolySet::reverse_polygons()
+{
+  this->polygons.reverseAll();
+}
+
+void PolySet::translate(const Vector3d& translation)
+{
+  for (auto& v : this->polygons.vertices) {
+    v += translation;
   }
   this->dirty = true;
 }
@@ -204,32 +230,57 @@ void PolySet::resize(const Vector3d& newsize, const Eigen::Matrix<bool, 3, 1>& a
  */
 void PolySet::quantizeVertices(std::vector<Vector3d> *pPointsOut)
 {
+  constexpr unsigned int unaligned = std::numeric_limits<unsigned int>::max();
+  // Vertices are aligned in the order polygons use them
+  std::vector<unsigned int> gridIndices(this->polygons.vertices.size(), unaligned);
+  std::vector<int> used;
+  for (int vertex : this->polygons.indices) {
+    if (gridIndices[vertex] != unaligned) continue;
+    gridIndices[vertex] = 0;
+    used.push_back(vertex);
+  }
+  std::vector<Vector3d> points(used.size());
+  for (size_t i = 0; i < used.size(); ++i) points[i] = this->polygons.vertices[used[i]];
+
   Grid3d<unsigned int> grid(GRID_FINE);
-  std::vector<unsigned int> indices; // Vertex indices in one polygon
-  for (auto iter = this->polygons.begin(); iter != this->polygons.end();) {
-    Polygon& p = *iter;
-    indices.resize(p.size());
-    // Quantize all vertices. Build index list
-    for (unsigned int i = 0; i < p.size(); ++i) {
-      auto index = indices[i] = grid.align(p[i]);
-      if (pPointsOut && index == grid.db.size() - 1) {
-        pPointsOut->push_back(p[i]);
-      }
+  const auto aligned = grid.align(points, Feature::ExperimentalParallelQuantization.is_enabled());
+  unsigned int numAligned = 0;
+  for (size_t i = 0; i < used.size(); ++i) {
+    this->polygons.vertices[used[i]] = points[i];
+    gridIndices[used[i]] = aligned[i];
+    if (pPointsOut && aligned[i] == numAligned) {
+      pPointsOut->push_back(points[i]);
+      ++numAligned;
     }
-    // Remove consecutive duplicate vertices
-    auto currp = p.begin();
-    for (unsigned int i = 0; i < indices.size(); ++i) {
-      if (indices[i] != indices[(i + 1) % indices.size()]) {
-        (*currp++) = p[i];
+  }
+
+  // Remove consecutive duplicate vertices
+  auto& indices = this->polygons.indices;
+  auto& offsets = this->polygons.offsets;
+  size_t out = 0;
+  size_t kept = 0;
+  for (size_t face = 0; face + 1 < offsets.size(); ++face) {
+    const size_t first = offsets[face];
+    const size_t n = offsets[face + 1] - first;
+    const size_t start = out;
+    const int firstVertex = n > 0 ? indices[first] : 0; // may be overwritten below
+    for (size_t i = 0; i < n; ++i) {
+      const int vertex = indices[first + i];
+      const int next = i + 1 < n ? indices[first + i + 1] : firstVertex;
+      if (gridIndices[vertex] != gridIndices[next]) {
+        indices[out++] = vertex;
       }
     }
-    p.erase(currp, p.end());
-    if (p.size() < 3) {
+    if (out - start < 3) {
       PRINTD("Removing collapsed polygon due to quantizing");
-      this->polygons.erase(iter);
+      out = start;
     } else {
-      iter++;
+      offsets[kept++] = start;
     }
   }
+  offsets[kept] = out;
+  offsets.resize(kept + 1);
+  indices.resize(out);
+  this->dirty = true;
 }
 
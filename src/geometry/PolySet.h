@@ -4,6 +4,7 @@
 #include "linalg.h"
 #include "GeometryUtils.h"
 #include "Polygon2d.h"
+#include "PolygonList.h"
 #include "boost-utils.h"
 
 #include <vector>
@@ -13,7 +14,7 @@ class PolySet : public Geometry
 {
 public:
   VISITABLE_GEOMETRY();
-  Polygons polygons;
+  PolygonList polygons;
 
   PolySet(unsigned int dim, boost::tribool convex = unknown);
   PolySet(Polygon2d origin);
@@ -29,16 +30,23 @@ public:
 
   void quantizeVertices(std::vector<Vector3d> *pPointsOut = nullptr);
   size_t numFacets() const override { return polygons.size(); }
-  void reserve(size_t numFacets) { polygons.reserve(numFacets); }
+  void reserve(size_t numFacets, size_t numCorners = 0) { polygons.reserve(numFacets, numCorners); }
   void append_poly();
   void append_poly(const Polygon& poly);
   void append_vertex(double x, double y, double z = 0.0);
   void append_vertex(const Vector3d& v);
   void append_vertex(const Vector3f& v);
+  // Adds a vertex which can then be shared by several polygons, using append_index().
+  int add_vertex(const Vector3d& v);
+  void append_index(int index);
   void insert_vertex(double x, double y, double z = 0.0);
   void insert_vertex(const Vector3d& v);
   void insert_vertex(const Vector3f& v);
   void append(const PolySet& ps);
+  void reverse_polygons();
+  void translate(const Vector3d& translation);
+  // Must be called after modifying polygons directly.
+  void setDirty() { this->dirty = true; }
 
   void transform(const Transform3d& mat) override;
   void resize(const Vector3d& newsize, const Eigen::Matrix<bool, 3, 1>& autosize) override;
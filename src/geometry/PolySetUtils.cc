@@ -1,9 +1,14 @@
 #include "PolySetUtils.h"
 #include "PolySet.h"
 #include "Polygon2d.h"
+#include "ClipperUtils.h"
+#include "hash.h"
 #include "printutils.h"
 #include "GeometryUtils.h"
 #include "Reindexer.h"
+#include "Trace.h"
+#include "Feature.h"
+#include "parallel.h"
 #ifdef ENABLE_CGAL
 #include "cgalutils.h"
 #endif
@@ -26,6 +31,189 @@ Polygon2d *project(const PolySet& ps) {
   return poly;
 }
 
+namespace {
+
+// Whether every edge is shared with a face going the opposite way, as in a
+// closed and consistently oriented mesh.
+bool isClosed(const PolySet& ps)
+{
+  Reindexer<Vector3d> vertices;
+  std::unordered_map<uint64_t, int> edges;
+  for (const auto& p : ps.polygons) {
+    for (size_t i = 0; i < p.size(); ++i) {
+      const uint64_t a = vertices.lookup(p[i]);
+      const uint64_t b = vertices.lookup(p[(i + 1) % p.size()]);
+      edges[a < b ? (a << 32) | b : (b << 32) | a] += a < b ? 1 : -1;
+    }
+  }
+  return std::all_of(edges.begin(), edges.end(), [](const auto& edge) { return edge.second == 0; });
+}
+
+} // namespace
+
+/* Like project(), but leaves out the faces seen from behind when the mesh is
+   closed, since the faces seen from the front cover the same shadow. Only
+   faces whose projection is clearly reversed are left out, as leaving out a
+   face seen edge-on based on a rounded orientation could open a crack.
+ */
+Polygon2d *projectFrontFaces(const PolySet& ps)
+{
+  if (!isClosed(ps)) return project(ps);
+
+  auto poly = new Polygon2d;
+  for (const auto& p : ps.polygons) {
+    Outline2d outline;
+    double area = 0;
+    BoundingBox bounds;
+    for (size_t i = 0; i < p.size(); ++i) {
+      const auto& v = p[i];
+      const auto& next = p[(i + 1) % p.size()];
+      area += v[0] * next[1] - next[0] * v[1];
+      bounds.extend(v);
+      outline.vertices.emplace_back(v[0], v[1]);
+    }
+    if (area < -1e-9 * bounds.sizes().squaredNorm()) continue;
+    poly->addOutline(outline);
+  }
+  return poly;
+}
+
+namespace {
+
+// Point where the edge from a vertex below z=0 to one above it crosses the
+// plane. It only depends on the ordered vertices, so both faces sharing an
+// edge get exactly the same point.
+Vector3d crossing(const Vector3d& below, const Vector3d& above)
+{
+  if (above[2] == 0) return above;
+  const double t = below[2] / (below[2] - above[2]);
+  return {below[0] + (above[0] - below[0]) * t, below[1] + (above[1] - below[1]) * t, 0};
+}
+
+// Chains the segments of the cross-section of a triangle mesh into outlines.
+// Returns false if the mesh isn't closed.
+bool sliceTriangles(const PolySet& ps, Polygon2d& outlines)
+{
+  // Vertices on the plane count as above it. This perturbs the plane
+  // slightly downwards, which only drops zero area parts of the section.
+  std::vector<std::pair<Vector3d, Vector3d>> segments;
+  for (const auto& p : ps.polygons) {
+    if (p.size() != 3) return false;
+    if (p[0][2] == 0 && p[1][2] == 0 && p[2][2] == 0) return false;
+    Vector3d start, end;
+    bool crosses = false;
+    for (size_t i = 0; i < 3; ++i) {
+      const Vector3d& a = p[i];
+      const Vector3d& b = p[(i + 1) % 3];
+      if (a[2] >= 0 && b[2] < 0) {
+        start = crossing(b, a);
+        crosses = true;
+      } else if (a[2] < 0 && b[2] >= 0) {
+        end = crossing(a, b);
+      }
+    }
+    // Segments follow the winding of their faces, so all outlines of a
+    // consistently oriented mesh wind the same way around its material.
+    if (crosses && start != end) segments.emplace_back(start, end);
+  }
+
+  std::unordered_multimap<Vector3d, size_t> outgoing;
+  outgoing.reserve(segments.size());
+  for (size_t i = 0; i < segments.size(); ++i) outgoing.emplace(segments[i].first, i);
+  std::vector<bool> used(segments.size());
+
+  for (size_t first = 0; first < segments.size(); ++first) {
+    if (used[first]) continue;
+    Outline2d outline;
+    size_t current = first;
+    while (true) {
+      used[current] = true;
+      const auto& segment = segments[current];
+      outline.vertices.emplace_back(segment.first[0], segment.first[1]);
+      if (segment.second == segments[first].first) break;
+      auto range = outgoing.equal_range(segment.second);
+      auto next = std::find_if(range.first, range.second, [&](const auto& entry) {
+          return !used[entry.second];
+        });
+      if (next == range.second) return false;
+      current = next->second;
+    }
+    outlines.addOutline(outline);
+  }
+  return true;
+}
+
+} // namespace
+
+/* Cross-section of a closed mesh with the plane z=0, as computed by
+   projection(cut=true), without going through Nef polyhedra.
+
+   Faces crossing the plane are cut into segments which are chained into
+   outlines, and the outlines are resolved with a nonzero union. Returns
+   nullptr if the mesh isn't closed or has faces lying in the plane, for the
+   caller to fall back to an exact cut.
+ */
+Polygon2d *slice(const PolySet& ps)
+{
+  Trace::Span span("geometry", "slice");
+  span.arg("polygons", ps.polygons.size());
+
+  Polygon2d outlines;
+  bool sliced;
+  if (std::all_of(ps.polygons.begin(), ps.polygons.end(), [](const auto& p) { return p.size() == 3; })) {
+    sliced = sliceTriangles(ps, outlines);
+  } else {
+    PolySet triangles(3);
+    tessellate_faces(ps, triangles);
+    sliced = sliceTriangles(triangles, outlines);
+  }
+  if (!sliced) return nullptr;
+  if (outlines.outlines().empty()) return new Polygon2d;
+
+  // Keep the orientation of the outlines, as it tells holes apart.
+  const int pow2 = ClipperUtils::getScalePow2(outlines.getBoundingBox());
+  const double scale = std::ldexp(1.0, pow2);
+  ClipperLib::Paths paths;
+  for (const auto& outline : outlines.outlines()) {
+    ClipperLib::Path path;
+    for (const auto& v : outline.vertices) path.emplace_back(v[0] * scale, v[1] * scale);
+    paths.push_back(std::move(path));
+  }
+  ClipperLib::Clipper clipper;
+  clipper.AddPaths(paths, ClipperLib::ptSubject, true);
+  ClipperLib::PolyTree result;
+  clipper.StrictlySimple(true);
+  clipper.Execute(ClipperLib::ctUnion, result, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+  return ClipperUtils::toPolygon2d(result, pow2);
+}
+
+namespace {
+
+// Whether the face is strictly convex when seen along its normal, so that a
+// fan of triangles around its first vertex covers it.
+bool isConvexFace(const std::vector<Vector3f>& vertices, const IndexedFace& face)
+{
+  const size_t n = face.size();
+  Vector3d normal = Vector3d::Zero();
+  for (size_t i = 0; i < n; ++i) {
+    normal += vertices[face[i]].cast<double>().cross(vertices[face[(i + 1) % n]].cast<double>());
+  }
+  const Vector3d v0 = vertices[face[0]].cast<double>();
+  const Vector3d v1 = vertices[face[1]].cast<double>();
+  for (size_t i = 0; i < n; ++i) {
+    const Vector3d prev = vertices[face[(i + n - 1) % n]].cast<double>();
+    const Vector3d v = vertices[face[i]].cast<double>();
+    const Vector3d next = vertices[face[(i + 1) % n]].cast<double>();
+    // Every corner turns the same way...
+    if ((v - prev).cross(next - v).dot(normal) <= 0) return false;
+    // ...and the polygon only winds once, i.e. stays on one side of its first edge.
+    if (i >= 2 && (v1 - v0).cross(v - v0).dot(normal) <= 0) return false;
+  }
+  return true;
+}
+
+} // namespace
+
 /* Tessellation of 3d PolySet faces
 
    This code is for tessellating the faces of a 3d PolySet, assuming that
@@ -47,6 +235,8 @@ Polygon2d *project(const PolySet& ps) {
  */
 void tessellate_faces(const PolySet& inps, PolySet& outps)
 {
+  Trace::Span span("geometry", "tessellate_faces");
+  span.arg("polygons", inps.polygons.size());
   int degeneratePolygons = 0;
 
   // Build Indexed PolyMesh
@@ -56,8 +246,21 @@ void tessellate_faces(const PolySet& inps, PolySet& outps)
   // best estimate without iterating all polygons, to reduce reallocations
   polygons.reserve(inps.polygons.size() );
 
-  // minimum estimate without iterating all polygons, to reduce reallocation and rehashing
-  allVertices.reserve(3 * inps.polygons.size() );
+  // Vertices are rounded to float, which can merge some of them. Each one is
+  // looked up once, in the order polygons first use them.
+  std::vector<int> used(inps.polygons.vertices.size(), -1);
+  std::vector<Vector3f> usedVertices;
+  for (const auto& pgon : inps.polygons) {
+    if (pgon.size() < 3) continue;
+    for (size_t i = 0; i < pgon.size(); ++i) {
+      const int vertex = pgon.index(i);
+      if (used[vertex] >= 0) continue;
+      used[vertex] = usedVertices.size();
+      usedVertices.push_back(pgon[i].cast<float>());
+    }
+  }
+  std::vector<int> lookedUp(usedVertices.size());
+  allVertices.lookup(usedVertices.data(), usedVertices.size(), lookedUp.data());
 
   for (const auto& pgon : inps.polygons) {
     if (pgon.size() < 3) {
@@ -69,10 +272,9 @@ void tessellate_faces(const PolySet& inps, PolySet& outps)
     auto& faces = polygons.back();
     faces.push_back(IndexedFace());
     auto& currface = faces.back();
-    for (const auto& v : pgon) {
+    for (size_t i = 0; i < pgon.size(); ++i) {
       // Create vertex indices and remove consecutive duplicate vertices
-      // NOTE: a lot of time is spent here (cast+hash+lookup+insert+rehash)
-      auto idx = allVertices.lookup(v.cast<float>());
+      auto idx = lookedUp[used[pgon.index(i)]];
       if (currface.empty() || idx != currface.back()) currface.push_back(idx);
     }
     if (currface.front() == currface.back()) currface.pop_back();
@@ -84,35 +286,62 @@ void tessellate_faces(const PolySet& inps, PolySet& outps)
 
   // Tessellate indexed mesh
   const auto& verts = allVertices.getArray();
+  const bool fastTessellation = Feature::ExperimentalFastTessellation.is_enabled();
+
+  // Appends the triangles of polygons [begin, end) to triangles.
+  auto tessellate = [&](size_t begin, size_t end, std::vector<IndexedTriangle>& triangles) {
+      for (size_t p = begin; p < end; ++p) {
+        const auto& faces = polygons[p];
+        const auto& face = faces[0];
+        if (face.size() == 3) {
+          // trivial case - triangles cannot be concave or have holes
+          triangles.emplace_back(face[0], face[1], face[2]);
+        }
+        // Quads seem trivial, but can be concave, and can have degenerate cases.
+        // So unless they are convex, everything more complex than triangles
+        // goes into the general case.
+        else if (fastTessellation && isConvexFace(verts, face)) {
+          for (size_t i = 1; i + 1 < face.size(); ++i) triangles.emplace_back(face[0], face[i], face[i + 1]);
+        } else {
+          const size_t size = triangles.size();
+          auto err = GeometryUtils::tessellatePolygonWithHoles(verts, faces, triangles, nullptr);
+          if (err) triangles.resize(size);
+        }
+      }
+    };
+
+  // Polygons are split into contiguous ranges tessellated on separate
+  // threads, and their triangles are put back together in order.
+  constexpr size_t minPolygonsPerThread = 1000;
+  const size_t numThreads = !Feature::ExperimentalParallelTessellation.is_enabled() || Parallel::isWorker() ? 1 :
+                            std::min<size_t>(Parallel::concurrency(), polygons.size() / minPolygonsPerThread);
+  std::vector<std::vector<IndexedTriangle>> triangles(std::max<size_t>(numThreads, 1));
+  if (numThreads > 1) {
+    Parallel::run(numThreads, [&](size_t thread) {
+      tessellate(polygons.size() * thread / numThreads, polygons.size() * (thread + 1) / numThreads, triangles[thread]);
+    });
+  } else {
+    // Estimate how many triangles we will need and preallocate.
+    // This is usually an undercount, but still prevents a lot of reallocations.
+    triangles[0].reserve(polygons.size());
+    tessellate(0, polygons.size(), triangles[0]);
+  }
+  span.arg("threads", triangles.size());
 
-  // we will reuse this memory instead of reallocating for each polygon
-  std::vector<IndexedTriangle> triangles;
+  size_t numTriangles = 0;
+  for (const auto& t : triangles) numTriangles += t.size();
+  outps.reserve(numTriangles, 3 * numTriangles);
 
-  // Estimate how many polygons we will need and preallocate.
-  // This is usually an undercount, but still prevents a lot of reallocations.
-  outps.polygons.reserve(polygons.size() );
+  // Output triangles share the vertices of the indexed mesh
+  const int base = outps.polygons.vertices.size();
+  for (const auto& v : verts) outps.add_vertex(v.cast<double>());
 
-  for (const auto& faces : polygons) {
-    if (faces[0].size() == 3) {
-      // trivial case - triangles cannot be concave or have holes
+  for (const auto& chunk : triangles) {
+    for (const auto& t : chunk) {
       outps.append_poly();
-      outps.append_vertex(verts[faces[0][0]]);
-      outps.append_vertex(verts[faces[0][1]]);
-      outps.append_vertex(verts[faces[0][2]]);
-    }
-    // Quads seem trivial, but can be concave, and can have degenerate cases.
-    // So everything more complex than triangles goes into the general case.
-    else {
-      triangles.clear();
-      auto err = GeometryUtils::tessellatePolygonWithHoles(verts, faces, triangles, nullptr);
-      if (!err) {
-        for (const auto& t : triangles) {
-          outps.append_poly();
-          outps.append_vertex(verts[t[0]]);
-          outps.append_vertex(verts[t[1]]);
-          outps.append_vertex(verts[t[2]]);
-        }
-      }
+      outps.append_index(base + t[0]);
+      outps.append_index(base + t[1]);
+      outps.append_index(base + t[2]);
     }
   }
 
@@ -6,6 +6,8 @@ class PolySet;
 namespace PolySetUtils {
 
 Polygon2d *project(const PolySet& ps);
+Polygon2d *projectFrontFaces(const PolySet& ps);
+Polygon2d *slice(const PolySet& ps);
 void tessellate_faces(const PolySet& inps, PolySet& outps);
 bool is_approximately_convex(const PolySet& ps);
 
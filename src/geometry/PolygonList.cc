@@ -0,0 +1,59 @@
+#include "PolygonList.h"
+
+#include <algorithm>
+
+void PolygonList::reserve(size_t numPolygons, size_t numCorners)
+{
+  offsets.reserve(numPolygons + 1);
+  if (numCorners > 0) {
+    indices.reserve(numCorners);
+    vertices.reserve(numCorners);
+  }
+}
+
+void PolygonList::clear()
+{
+  vertices.clear();
+  indices.clear();
+  offsets.assign(1, 0);
+}
+
+void PolygonList::insertVertex(const Vector3d& v)
+{
+  const int index = addVertex(v);
+  indices.insert(indices.begin() + offsets[size() - 1], index);
+  offsets.back() = indices.size();
+}
+
+void PolygonList::append(const Polygon& polygon)
+{
+  beginPolygon();
+  for (const auto& v : polygon) appendVertex(v);
+}
+
+void PolygonList::append(const PolygonList& other)
+{
+  const int base = static_cast<int>(vertices.size());
+  const size_t indexBase = indices.size();
+  vertices.insert(vertices.end(), other.vertices.begin(), other.vertices.end());
+  indices.reserve(indices.size() + other.indices.size());
+  for (int index : other.indices) indices.push_back(base + index);
+  offsets.reserve(offsets.size() + other.size());
+  for (size_t face = 1; face < other.offsets.size(); ++face) {
+    offsets.push_back(indexBase + other.offsets[face]);
+  }
+}
+
+void PolygonList::reverseAll()
+{
+  for (size_t face = 0; face < size(); ++face) {
+    std::reverse(indices.begin() + offsets[face], indices.begin() + offsets[face + 1]);
+  }
+}
+
+size_t PolygonList::memsize() const
+{
+  return vertices.size() * sizeof(Vector3d) +
+         indices.size() * sizeof(int) +
+         offsets.size() * sizeof(size_t);
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "GeometryUtils.h"
+
+/*!
+   A list of polygons stored contiguously, in compressed sparse row form.
+
+   All polygons share one vertex buffer. Their corners are kept in one flat
+   buffer of vertex indices, and polygon i uses the indices in
+   [offsets[i], offsets[i + 1]). Vertices can be shared by several polygons.
+
+   Iterating yields lightweight Face views which behave like a const Polygon,
+   so code reading a std::vector<Polygon> works unchanged. Code modifying
+   vertices should work on the vertex buffer directly.
+ */
+class PolygonList
+{
+public:
+  class Face
+  {
+public:
+    class const_iterator
+    {
+public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = Vector3d;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const Vector3d *;
+      using reference = const Vector3d&;
+
+      const_iterator() = default;
+      const_iterator(const Vector3d *vertices, const int *index) : vertices(vertices), index(index) {}
+
+      reference operator*() const { return vertices[*index]; }
+      pointer operator->() const { return &vertices[*index]; }
+      reference operator[](difference_type n) const { return vertices[index[n]]; }
+      const_iterator& operator++() { ++index; return *this; }
+      const_iterator operator++(int) { auto it = *this; ++index; return it; }
+      const_iterator& operator--() { --index; return *this; }
+      const_iterator operator--(int) { auto it = *this; --index; return it; }
+      const_iterator& operator+=(difference_type n) { index += n; return *this; }
+      const_iterator& operator-=(difference_type n) { index -= n; return *this; }
+      const_iterator operator+(difference_type n) const { return {vertices, index + n}; }
+      const_iterator operator-(difference_type n) const { return {vertices, index - n}; }
+      difference_type operator-(const const_iterator& other) const { return index - other.index; }
+      bool operator==(const const_iterator& other) const { return index == other.index; }
+      bool operator!=(const const_iterator& other) const { return index != other.index; }
+      bool operator<(const const_iterator& other) const { return index < other.index; }
+      bool operator>(const const_iterator& other) const { return index > other.index; }
+      bool operator<=(const const_iterator& other) const { return index <= other.index; }
+      bool operator>=(const const_iterator& other) const { return index >= other.index; }
+
+private:
+      const Vector3d *vertices = nullptr;
+      const int *index = nullptr;
+    };
+
+    Face(const PolygonList& list, size_t face)
+      : list(&list), first(list.offsets[face]), last(list.offsets[face + 1]) {}
+
+    [[nodiscard]] size_t size() const { return last - first; }
+    [[nodiscard]] bool empty() const { return first == last; }
+    const Vector3d& operator[](size_t i) const { return list->vertices[list->indices[first + i]]; }
+    const Vector3d& at(size_t i) const {
+      if (i >= size()) throw std::out_of_range("PolygonList::Face::at");
+      return (*this)[i];
+    }
+    const Vector3d& front() const { return (*this)[0]; }
+    const Vector3d& back() const { return (*this)[size() - 1]; }
+    [[nodiscard]] const_iterator begin() const { return {list->vertices.data(), list->indices.data() + first}; }
+    [[nodiscard]] const_iterator end() const { return {list->vertices.data(), list->indices.data() + last}; }
+
+    // Index of the i-th corner in the shared vertex buffer.
+    [[nodiscard]] int index(size_t i) const { return list->indices[first + i]; }
+
+    operator Polygon() const { return Polygon(begin(), end()); }
+
+private:
+    const PolygonList *list;
+    size_t first;
+    size_t last;
+  };
+
+  class const_iterator
+  {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Face;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    // Faces are views, so they are returned by value. Being const lets both
+    // `const auto&` and `auto&` loop variables bind to them.
+    using reference = const Face;
+
+    const_iterator() = default;
+    const_iterator(const PolygonList *list, size_t face) : list(list), face(face) {}
+
+    reference operator*() const { return {*list, face}; }
+    reference operator[](difference_type n) const { return {*list, face + n}; }
+    const_iterator& operator++() { ++face; return *this; }
+    const_iterator operator++(int) { auto it = *this; ++face; return it; }
+    const_iterator& operator--() { --face; return *this; }
+    const_iterator operator--(int) { auto it = *this; --face; return it; }
+    const_iterator& operator+=(difference_type n) { face += n; return *this; }
+    const_iterator& operator-=(difference_type n) { face -= n; return *this; }
+    const_iterator operator+(difference_type n) const { return {list, face + n}; }
+    const_iterator operator-(difference_type n) const { return {list, face - n}; }
+    difference_type operator-(const const_iterator& other) const {
+      return static_cast<difference_type>(face) - static_cast<difference_type>(other.face);
+    }
+    bool operator==(const const_iterator& other) const { return face == other.face; }
+    bool operator!=(const const_iterator& other) const { return face != other.face; }
+    bool operator<(const const_iterator& other) const { return face < other.face; }
+
+private:
+    const PolygonList *list = nullptr;
+    size_t face = 0;
+  };
+  using iterator = const_iterator;
+
+  [[nodiscard]] size_t size() const { return offsets.size() - 1; }
+  [[nodiscard]] bool empty() const { return offsets.size() == 1; }
+  const Face operator[](size_t i) const { return {*this, i}; }
+  const Face front() const { return {*this, 0}; }
+  const Face back() const { return {*this, size() - 1}; }
+  [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+  [[nodiscard]] const_iterator end() const { return {this, size()}; }
+
+  // Reserves room for polygons, and optionally for their corners.
+  void reserve(size_t numPolygons, size_t numCorners = 0);
+  void clear();
+
+  // Adds a vertex to the shared buffer without using it in a polygon yet.
+  int addVertex(const Vector3d& v) {
+    vertices.push_back(v);
+    return static_cast<int>(vertices.size() - 1);
+  }
+  // Starts a new, empty polygon.
+  void beginPolygon() { offsets.push_back(indices.size()); }
+  // Adds a corner to the last polygon.
+  void appendIndex(int index) {
+    indices.push_back(index);
+    offsets.back() = indices.size();
+  }
+  void appendVertex(const Vector3d& v) { appendIndex(addVertex(v)); }
+  // Adds a corner at the start of the last polygon.
+  void insertVertex(const Vector3d& v);
+  void append(const Polygon& polygon);
+  void append(const PolygonList& other);
+
+  // Reverses the corner order of every polygon.
+  void reverseAll();
+
+  // Keeps the polygons for which keep(face) returns true.
+  template <typename Predicate> void filter(Predicate keep);
+
+  [[nodiscard]] size_t memsize() const;
+
+  std::vector<Vector3d> vertices;
+  std::vector<int> indices;
+  std::vector<size_t> offsets{0}; // one more than the number of polygons
+};
+
+template <typename Predicate> void PolygonList::filter(Predicate keep)
+{
+  size_t out = 0;
+  size_t kept = 0;
+  for (size_t face = 0; face < size(); ++face) {
+    const size_t first = offsets[face];
+    const size_t last = offsets[face + 1];
+    if (!keep(Face(*this, face))) continue;
+    offsets[kept++] = out;
+    for (size_t i = first; i < last; ++i) indices[out++] = indices[i];
+  }
+  offsets[kept] = out;
+  offsets.resize(kept + 1);
+  indices.resize(out);
+}
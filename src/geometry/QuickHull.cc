@@ -0,0 +1,336 @@
+#include "QuickHull.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "parallel.h"
+#include "PolySet.h"
+#include "Trace.h"
+
+namespace QuickHull {
+
+namespace {
+
+struct Face {
+  std::array<int, 3> vertices;
+  Vector3d normal; // unit length, pointing out
+  double offset;
+  std::vector<int> outside; // points in front of the face, not yet on the hull
+  bool alive = true;
+  int mark = 0;
+
+  [[nodiscard]] double distance(const Vector3d& p) const { return normal.dot(p) - offset; }
+};
+
+uint64_t edgeKey(int from, int to)
+{
+  return (static_cast<uint64_t>(from) << 32) | static_cast<uint32_t>(to);
+}
+
+// Distance below which a point counts as on a plane, as used by qhull and
+// other floating point quickhull implementations.
+double tolerance(const std::vector<Vector3d>& points)
+{
+  Vector3d maxAbs = Vector3d::Zero();
+  for (const auto& p : points) maxAbs = maxAbs.cwiseMax(p.cwiseAbs());
+  return 3 * DBL_EPSILON * (maxAbs[0] + maxAbs[1] + maxAbs[2]);
+}
+
+class HullBuilder
+{
+public:
+  HullBuilder(const std::vector<Vector3d>& points, double eps) : points(points), eps(eps) {}
+
+  bool build();
+  void toPolySet(PolySet& ps) const;
+
+  // Whether p is inside the hull by more than the tolerance.
+  [[nodiscard]] bool isStrictlyInside(const Vector3d& p) const {
+    return std::all_of(faces.begin(), faces.end(), [&](const Face& face) {
+      return !face.alive || face.distance(p) < -eps;
+    });
+  }
+
+private:
+  bool buildSimplex(std::array<int, 4>& simplex) const;
+  bool addFace(int a, int b, int c);
+  bool addPoint(int faceIndex);
+  void assign(const std::vector<int>& candidates, size_t firstFace);
+  [[nodiscard]] bool isClosed() const;
+
+  const std::vector<Vector3d>& points;
+  const double eps;
+  std::vector<Face> faces;
+  std::unordered_map<uint64_t, int> edges; // directed edge -> face on its left
+  int mark = 0;
+};
+
+bool HullBuilder::buildSimplex(std::array<int, 4>& simplex) const
+{
+  std::array<int, 3> minIndex{0, 0, 0}, maxIndex{0, 0, 0};
+  for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      if (points[i][axis] < points[minIndex[axis]][axis]) minIndex[axis] = i;
+      if (points[i][axis] > points[maxIndex[axis]][axis]) maxIndex[axis] = i;
+    }
+  }
+  int widest = 0;
+  for (int axis = 1; axis < 3; ++axis) {
+    if (points[maxIndex[axis]][axis] - points[minIndex[axis]][axis] >
+        points[maxIndex[widest]][widest] - points[minIndex[widest]][widest]) widest = axis;
+  }
+  simplex[0] = minIndex[widest];
+  simplex[1] = maxIndex[widest];
+  const Vector3d& p0 = points[simplex[0]];
+  const Vector3d& p1 = points[simplex[1]];
+  if ((p1 - p0).norm() <= eps) return false;
+
+  const Vector3d direction = (p1 - p0).normalized();
+  double best = 0;
+  for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+    const double d = direction.cross(points[i] - p0).norm();
+    if (d > best) {
+      best = d;
+      simplex[2] = i;
+    }
+  }
+  if (best <= eps) return false;
+
+  const Vector3d normal = (p1 - p0).cross(points[simplex[2]] - p0).normalized();
+  best = 0;
+  for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+    const double d = std::abs(normal.dot(points[i] - p0));
+    if (d > best) {
+      best = d;
+      simplex[3] = i;
+    }
+  }
+  return best > eps;
+}
+
+bool HullBuilder::addFace(int a, int b, int c)
+{
+  const Vector3d& pa = points[a];
+  const Vector3d normal = (points[b] - pa).cross(points[c] - pa);
+  const double length = normal.norm();
+  // A sliver whose normal is lost in rounding.
+  if (length <= eps * std::max((points[b] - pa).norm(), (points[c] - pa).norm())) return false;
+
+  Face face;
+  face.vertices = {a, b, c};
+  face.normal = normal / length;
+  face.offset = face.normal.dot(pa);
+  const int index = static_cast<int>(faces.size());
+  for (int i = 0; i < 3; ++i) edges[edgeKey(face.vertices[i], face.vertices[(i + 1) % 3])] = index;
+  faces.push_back(std::move(face));
+  return true;
+}
+
+// Gives each candidate point to the first face from firstFace on that it is
+// in front of. Points in front of no face are inside the hull.
+void HullBuilder::assign(const std::vector<int>& candidates, size_t firstFace)
+{
+  for (int i : candidates) {
+    for (size_t f = firstFace; f < faces.size(); ++f) {
+      if (faces[f].distance(points[i]) > eps) {
+        faces[f].outside.push_back(i);
+        break;
+      }
+    }
+  }
+}
+
+// Adds the farthest point in front of a face to the hull.
+bool HullBuilder::addPoint(int faceIndex)
+{
+  const auto& outside = faces[faceIndex].outside;
+  const int eye = *std::max_element(outside.begin(), outside.end(), [&](int a, int b) {
+    return faces[faceIndex].distance(points[a]) < faces[faceIndex].distance(points[b]);
+  });
+  const Vector3d& eyePoint = points[eye];
+
+  // Find the faces visible from the eye point, and the horizon around them.
+  ++mark;
+  std::vector<int> visible{faceIndex};
+  faces[faceIndex].mark = mark;
+  std::unordered_map<int, int> horizon; // from -> to, around the visible region
+  for (size_t i = 0; i < visible.size(); ++i) {
+    const Face& face = faces[visible[i]];
+    for (int e = 0; e < 3; ++e) {
+      const int from = face.vertices[e];
+      const int to = face.vertices[(e + 1) % 3];
+      const int neighbor = edges.at(edgeKey(to, from));
+      if (faces[neighbor].mark == mark) continue;
+      if (faces[neighbor].distance(eyePoint) > eps) {
+        faces[neighbor].mark = mark;
+        visible.push_back(neighbor);
+      } else if (!horizon.emplace(from, to).second) {
+        return false; // the horizon touches itself
+      }
+    }
+  }
+
+  // The horizon must be a single loop for the new faces to close the hull.
+  if (horizon.empty()) return false;
+  size_t length = 0;
+  int vertex = horizon.begin()->first;
+  do {
+    auto next = horizon.find(vertex);
+    if (next == horizon.end() || ++length > horizon.size()) return false;
+    vertex = next->second;
+  } while (vertex != horizon.begin()->first);
+  if (length != horizon.size()) return false;
+
+  std::vector<int> orphans;
+  for (int index : visible) {
+    Face& face = faces[index];
+    face.alive = false;
+    for (int i : face.outside) {
+      if (i != eye) orphans.push_back(i);
+    }
+    face.outside.clear();
+    face.outside.shrink_to_fit();
+    for (int e = 0; e < 3; ++e) edges.erase(edgeKey(face.vertices[e], face.vertices[(e + 1) % 3]));
+  }
+
+  const size_t firstNewFace = faces.size();
+  for (const auto& edge : horizon) {
+    if (!addFace(edge.first, edge.second, eye)) return false;
+  }
+  assign(orphans, firstNewFace);
+  return true;
+}
+
+bool HullBuilder::isClosed() const
+{
+  size_t numFaces = 0;
+  std::unordered_set<int> vertices;
+  for (const auto& face : faces) {
+    if (!face.alive) continue;
+    ++numFaces;
+    for (int e = 0; e < 3; ++e) {
+      vertices.insert(face.vertices[e]);
+      if (edges.count(edgeKey(face.vertices[(e + 1) % 3], face.vertices[e])) == 0) return false;
+    }
+  }
+  // Euler's formula for a closed triangle mesh of genus 0: V - E + F = 2 with E = 3F / 2.
+  return 2 * vertices.size() == numFaces + 4;
+}
+
+bool HullBuilder::build()
+{
+  if (points.size() < 4) return false;
+  std::array<int, 4> s;
+  if (!buildSimplex(s)) return false;
+
+  // Orient the faces of the tetrahedron away from its fourth vertex.
+  const Vector3d normal = (points[s[1]] - points[s[0]]).cross(points[s[2]] - points[s[0]]);
+  if (normal.dot(points[s[3]] - points[s[0]]) > 0) std::swap(s[1], s[2]);
+  if (!addFace(s[0], s[1], s[2]) || !addFace(s[0], s[3], s[1]) ||
+      !addFace(s[1], s[3], s[2]) || !addFace(s[2], s[3], s[0])) return false;
+
+  std::vector<int> candidates;
+  candidates.reserve(points.size());
+  for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+    if (i != s[0] && i != s[1] && i != s[2] && i != s[3]) candidates.push_back(i);
+  }
+  assign(candidates, 0);
+
+  // New faces are appended, so a single pass visits them all.
+  for (size_t i = 0; i < faces.size(); ++i) {
+    if (faces[i].alive && !faces[i].outside.empty() && !addPoint(static_cast<int>(i))) return false;
+  }
+  return isClosed();
+}
+
+void HullBuilder::toPolySet(PolySet& ps) const
+{
+  std::unordered_map<int, int> indices;
+  for (const auto& face : faces) {
+    if (!face.alive) continue;
+    ps.append_poly();
+    for (int v : face.vertices) {
+      auto inserted = indices.emplace(v, 0);
+      if (inserted.second) inserted.first->second = ps.add_vertex(points[v]);
+      ps.append_index(inserted.first->second);
+    }
+  }
+}
+
+} // namespace
+
+std::vector<Vector3d> filterInterior(const std::vector<Vector3d>& points)
+{
+  if (points.size() < 100) return points;
+  Trace::Span span("geometry", "QuickHull::filterInterior");
+  span.arg("points", points.size());
+
+  // Extreme points along the axes and the diagonals.
+  static const std::array<Vector3d, 7> directions{
+    Vector3d(1, 0, 0), Vector3d(0, 1, 0), Vector3d(0, 0, 1),
+    Vector3d(1, 1, 1), Vector3d(1, 1, -1), Vector3d(1, -1, 1), Vector3d(-1, 1, 1),
+  };
+  std::array<size_t, 14> extremes{};
+  std::array<double, 14> extents;
+  for (size_t d = 0; d < directions.size(); ++d) {
+    extents[2 * d] = extents[2 * d + 1] = directions[d].dot(points[0]);
+  }
+  for (size_t i = 1; i < points.size(); ++i) {
+    for (size_t d = 0; d < directions.size(); ++d) {
+      const double x = directions[d].dot(points[i]);
+      if (x < extents[2 * d]) {
+        extents[2 * d] = x;
+        extremes[2 * d] = i;
+      }
+      if (x > extents[2 * d + 1]) {
+        extents[2 * d + 1] = x;
+        extremes[2 * d + 1] = i;
+      }
+    }
+  }
+  std::vector<Vector3d> polytopePoints;
+  for (size_t i : extremes) {
+    if (std::find(polytopePoints.begin(), polytopePoints.end(), points[i]) == polytopePoints.end()) {
+      polytopePoints.push_back(points[i]);
+    }
+  }
+
+  const double eps = tolerance(points);
+  HullBuilder polytope(polytopePoints, eps);
+  if (!polytope.build()) return points;
+
+  constexpr size_t minPointsPerChunk = 100000;
+  size_t numChunks = Parallel::isWorker() ? 1 : std::min<size_t>(Parallel::concurrency(), points.size() / minPointsPerChunk);
+  numChunks = std::max<size_t>(numChunks, 1);
+  std::vector<std::vector<Vector3d>> kept(numChunks);
+  const auto filterChunk = [&](size_t chunk) {
+      const size_t begin = points.size() * chunk / numChunks;
+      const size_t end = points.size() * (chunk + 1) / numChunks;
+      for (size_t i = begin; i < end; ++i) {
+        if (!polytope.isStrictlyInside(points[i])) kept[chunk].push_back(points[i]);
+      }
+    };
+  if (numChunks == 1) filterChunk(0);
+  else Parallel::run(numChunks, filterChunk);
+
+  std::vector<Vector3d> result;
+  for (auto& chunk : kept) result.insert(result.end(), chunk.begin(), chunk.end());
+  span.arg("kept", result.size());
+  return result;
+}
+
+bool hull(const std::vector<Vector3d>& points, PolySet& result)
+{
+  Trace::Span span("geometry", "QuickHull::hull");
+  span.arg("points", points.size());
+  HullBuilder builder(points, tolerance(points));
+  if (!builder.build()) return false;
+  builder.toPolySet(result);
+  return true;
+}
+
+} // namespace QuickHull
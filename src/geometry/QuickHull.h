@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include "linalg.h"
+
+class PolySet;
+
+/*!
+   Convex hulls of point clouds computed in floating point with the quickhull
+   algorithm.
+
+   Points closer to a face than a tolerance derived from the magnitude of the
+   input are considered to be on it. Configurations which the tolerance can't
+   decide, such as flat or inconsistent visibility regions, are reported as
+   failures so the caller can fall back to exact arithmetic.
+ */
+namespace QuickHull {
+
+// Drops the points strictly inside the hull of the extreme points along a
+// few fixed directions, which can't be hull vertices (Akl-Toussaint).
+std::vector<Vector3d> filterInterior(const std::vector<Vector3d>& points);
+
+// Computes the hull of points into result, as triangles. Returns false and
+// leaves result untouched if the hull can't be computed reliably.
+bool hull(const std::vector<Vector3d>& points, PolySet& result);
+
+} // namespace QuickHull
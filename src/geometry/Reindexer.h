@@ -1,17 +1,54 @@
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include <vector>
-#include <algorithm>
 #include "hash.h" // IWYU pragma: keep
 
+// Hashes of the values looked up by Reindexer. Vectors are hashed from the
+// bits of their coordinates, with -0 and 0 hashing the same since they are
+// equal.
+template <typename T>
+uint64_t reindexerHash(const T& val)
+{
+  return std::hash<T>()(val);
+}
+
+inline uint64_t reindexerHash(const Vector3d& v)
+{
+  uint64_t h = 0;
+  for (int i = 0; i < 3; ++i) {
+    const double x = v[i] + 0.0;
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    h = (h ^ bits) * 0x9e3779b97f4a7c15ULL;
+  }
+  return hash_mix(h);
+}
+
+inline uint64_t reindexerHash(const Vector3f& v)
+{
+  uint32_t bits[3];
+  for (int i = 0; i < 3; ++i) {
+    const float x = v[i] + 0.0f;
+    std::memcpy(&bits[i], &x, sizeof(bits[i]));
+  }
+  return hash_mix((uint64_t(bits[0]) << 32 | bits[1]) * 0x9e3779b97f4a7c15ULL ^ bits[2]);
+}
+
 /*!
    Reindexes a collection of elements of type T.
    Typically used to compress an element array by creating and reusing indexes to
    a new array or to merge two index tables to two arrays into a common index.
    The latter is necessary for VBO's or for unifying texture coordinate indices to
    multiple texture coordinate arrays.
+
+   The new element array is built as elements are looked up. The hash table
+   only holds indexes into it together with part of their hashes, using open
+   addressing with linear probing.
  */
 template <typename T>
 class Reindexer
@@ -21,11 +58,22 @@ public:
      Looks up a value. Will insert the value if it doesn't already exist.
      Returns the new index. */
   int lookup(const T& val) {
-    auto iter = this->map.find(val);
-    if (iter != this->map.end()) return iter->second;
-    else {
-      this->map.insert(std::make_pair(val, this->map.size()));
-      return this->map.size() - 1;
+    return this->insert(val, reindexerHash(val));
+  }
+
+  /*!
+     Looks up count values like lookup() does, one after the other, and
+     writes their indexes to indexes. Values are hashed a batch at a time
+     before any of them is looked up.
+   */
+  void lookup(const T *values, std::size_t count, int *indexes) {
+    this->reserve(this->vec.size() + count);
+    constexpr std::size_t batchSize = 64;
+    uint64_t hashes[batchSize];
+    for (std::size_t begin = 0; begin < count; begin += batchSize) {
+      const std::size_t n = std::min(batchSize, count - begin);
+      for (std::size_t i = 0; i < n; ++i) hashes[i] = reindexerHash(values[begin + i]);
+      for (std::size_t i = 0; i < n; ++i) indexes[begin + i] = this->insert(values[begin + i], hashes[i]);
     }
   }
 
@@ -33,24 +81,21 @@ public:
      Returns the current size of the new element array
    */
   [[nodiscard]] std::size_t size() const {
-    return this->map.size();
+    return this->vec.size();
   }
 
   /*!
      Reserve the requested size for the new element map
    */
   void reserve(std::size_t n) {
-    return this->map.reserve(n);
+    this->vec.reserve(n);
+    if (2 * n > this->slots.size()) this->rehash(2 * n);
   }
 
   /*!
-     Return a copy of the new element array
+     Return the new element array
    */
   const std::vector<T>& getArray() {
-    this->vec.resize(this->map.size());
-    for (const auto& entry : map) {
-      this->vec[entry.second] = entry.first;
-    }
     return this->vec;
   }
 
@@ -58,11 +103,49 @@ public:
      Copies the internal vector to the given destination
    */
   template <class OutputIterator> void copy(OutputIterator dest) {
-    this->getArray();
     std::copy(this->vec.begin(), this->vec.end(), dest);
   }
 
 private:
-  std::unordered_map<T, int> map;
+  struct Slot {
+    uint32_t index; // index + 1, 0 if the slot is free
+    uint32_t tag;   // high bits of the hash of the element
+  };
+
+  int insert(const T& val, uint64_t hash) {
+    if (2 * (this->vec.size() + 1) > this->slots.size()) {
+      this->rehash(std::max<std::size_t>(16, 2 * this->slots.size()));
+    }
+    const auto tag = uint32_t(hash >> 32);
+    std::size_t i = hash & this->mask;
+    for (;; i = (i + 1) & this->mask) {
+      const Slot& slot = this->slots[i];
+      if (slot.index == 0) break;
+      if (slot.tag == tag && this->vec[slot.index - 1] == val) return slot.index - 1;
+    }
+    this->vec.push_back(val);
+    this->slots[i] = {uint32_t(this->vec.size()), tag};
+    return this->vec.size() - 1;
+  }
+
+  // Rebuilds the table with size slots, a power of two.
+  void rehash(std::size_t size) {
+    std::size_t n = 16;
+    while (n < size) n *= 2;
+    std::vector<Slot> table(n, Slot{0, 0});
+    this->mask = n - 1;
+    for (const auto& slot : this->slots) {
+      if (slot.index == 0) continue;
+      // Slots only keep the high bits of the hashes, so the low ones are
+      // computed again.
+      std::size_t i = reindexerHash(this->vec[slot.index - 1]) & this->mask;
+      while (table[i].index != 0) i = (i + 1) & this->mask;
+      table[i] = slot;
+    }
+    this->slots.swap(table);
+  }
+
+  std::vector<Slot> slots;
+  std::size_t mask = 0;
   std::vector<T> vec;
 };
@@ -1,7 +1,13 @@
 #include "CGALCache.h"
 #include "printutils.h"
+#include "Trace.h"
 #include "CGAL_Nef_polyhedron.h"
 #include "CGALHybridPolyhedron.h"
+#include "PolySet.h"
+#include "hash.h"
+
+#include <boost/functional/hash.hpp>
+#include <sstream>
 
 CGALCache *CGALCache::inst = nullptr;
 
@@ -12,6 +18,7 @@ CGALCache::CGALCache(size_t limit) : cache(limit)
 shared_ptr<const Geometry> CGALCache::get(const std::string& id) const
 {
   const auto& N = this->cache[id]->N;
+  Trace::instant("cache", "CGALCache hit", "id", id);
 #ifdef DEBUG
   LOG(message_group::None, Location::NONE, "", "CGAL Cache hit: %1$s (%2$d bytes)", id.substr(0, 40), N ? N->memsize() : 0);
 #endif
@@ -27,7 +34,8 @@ bool CGALCache::acceptsGeometry(const shared_ptr<const Geometry>& geom) {
 bool CGALCache::insert(const std::string& id, const shared_ptr<const Geometry>& N)
 {
   assert(acceptsGeometry(N));
-  auto inserted = this->cache.insert(id, new cache_entry(N), N ? N->memsize() : 0);
+  auto inserted = insertEntry(id, new cache_entry(N), N ? N->memsize() : 0);
+  Trace::instant("cache", inserted ? "CGALCache insert" : "CGALCache insert failed", "id", id);
 #ifdef DEBUG
   if (inserted) LOG(message_group::None, Location::NONE, "", "CGAL Cache insert: %1$s (%2$d bytes)", id.substr(0, 40), (N ? N->memsize() : 0));
   else LOG(message_group::None, Location::NONE, "", "CGAL Cache insert failed: %1$s (%2$d bytes)", id.substr(0, 40), (N ? N->memsize() : 0));
@@ -35,6 +43,146 @@ bool CGALCache::insert(const std::string& id, const shared_ptr<const Geometry>&
   return inserted;
 }
 
+std::string CGALCache::decompositionKey(const PolySet& ps)
+{
+  size_t hash = 0;
+  for (const auto& v : ps.polygons.vertices) boost::hash_combine(hash, v);
+  for (int index : ps.polygons.indices) boost::hash_combine(hash, index);
+  for (size_t offset : ps.polygons.offsets) boost::hash_combine(hash, offset);
+  // Node ids never start with '#'
+  std::ostringstream key;
+  key << "#convex_decomposition(" << ps.polygons.vertices.size() << ", " << ps.polygons.size()
+      << ", " << std::hex << hash << ")";
+  return key.str();
+}
+
+shared_ptr<const CGALCache::ConvexParts> CGALCache::getDecomposition(const PolySet& ps) const
+{
+  const auto key = decompositionKey(ps);
+  auto entry = this->cache[key];
+  if (!entry) return nullptr;
+  // Different operands may share a key
+  const auto& source = entry->decompositionSource;
+  if (source.offsets != ps.polygons.offsets || source.indices != ps.polygons.indices ||
+      source.vertices != ps.polygons.vertices) return nullptr;
+  Trace::instant("cache", "CGALCache decomposition hit", "id", key);
+  return entry->parts;
+}
+
+bool CGALCache::insertDecomposition(const PolySet& ps, const shared_ptr<const ConvexParts>& parts)
+{
+  const auto key = decompositionKey(ps);
+  size_t cost = sizeof(ConvexParts) + key.size() + ps.polygons.memsize();
+  for (const auto& part : *parts) cost += sizeof(part) + part.size() * sizeof(Vector3d);
+  auto inserted = insertEntry(key, new cache_entry(ps.polygons, parts), cost);
+  Trace::instant("cache", inserted ? "CGALCache decomposition insert" : "CGALCache decomposition insert failed", "id", key);
+  return inserted;
+}
+
+/*!
+   Returns the offsets of points from the first one. Each coordinate is
+   stored as its rounded difference followed by the rounding error, which is
+   itself exact, so equal offsets mean the point clouds are exact translates.
+ */
+std::vector<double> CGALCache::hullOffsets(const std::vector<Vector3d>& points)
+{
+  std::vector<double> offsets;
+  offsets.reserve(points.size() * 6);
+  for (const auto& p : points) {
+    for (int i = 0; i < 3; ++i) {
+      // Knuth's TwoSum of p[i] and -points[0][i]
+      const double a = p[i], b = -points[0][i];
+      const double sum = a + b;
+      const double bVirtual = sum - a;
+      const double aVirtual = sum - bVirtual;
+      offsets.push_back(sum);
+      offsets.push_back((a - aVirtual) + (b - bVirtual));
+    }
+  }
+  return offsets;
+}
+
+std::string CGALCache::hullKey(const std::vector<double>& offsets)
+{
+  size_t hash = 0;
+  for (double offset : offsets) boost::hash_combine(hash, offset);
+  // Node ids never start with '#'
+  std::ostringstream key;
+  key << "#hull(" << offsets.size() / 6 << ", " << std::hex << hash << ")";
+  return key.str();
+}
+
+shared_ptr<const CGALCache::HullFaces> CGALCache::getHull(const std::vector<Vector3d>& points) const
+{
+  auto offsets = hullOffsets(points);
+  const auto key = hullKey(offsets);
+  auto entry = this->cache[key];
+  // Different point clouds may share a key
+  if (!entry || entry->hullOffsets != offsets) return nullptr;
+  Trace::instant("cache", "CGALCache hull hit", "id", key);
+  return entry->hull;
+}
+
+bool CGALCache::insertHull(const std::vector<Vector3d>& points, const shared_ptr<const HullFaces>& faces)
+{
+  auto offsets = hullOffsets(points);
+  const auto key = hullKey(offsets);
+  size_t cost = sizeof(cache_entry) + key.size() + offsets.size() * sizeof(double) +
+                sizeof(HullFaces) + faces->capacity() * sizeof(int);
+  auto inserted = insertEntry(key, new cache_entry(std::move(offsets), faces), cost);
+  Trace::instant("cache", inserted ? "CGALCache hull insert" : "CGALCache hull insert failed", "id", key);
+  return inserted;
+}
+
+std::string CGALCache::conversionKey(const Geometry& geom, const std::string& kind)
+{
+  // Node ids never start with '#'
+  std::ostringstream key;
+  key << "#conversion(" << kind << ", " << static_cast<const void *>(&geom) << ")";
+  return key.str();
+}
+
+shared_ptr<const void> CGALCache::getConversion(const shared_ptr<const Geometry>& geom, const std::string& kind)
+{
+  const auto key = conversionKey(*geom, kind);
+  auto entry = this->cache[key];
+  if (!entry) return nullptr;
+  // The address may belong to a new geometry once the old one is gone
+  if (entry->source.lock() != geom) {
+    this->cache.remove(key);
+    return nullptr;
+  }
+  Trace::instant("cache", "CGALCache conversion hit", "id", key);
+  return entry->converted;
+}
+
+bool CGALCache::insertConversion(const shared_ptr<const Geometry>& geom, const std::string& kind,
+                                 const shared_ptr<const void>& converted, size_t cost)
+{
+  const auto key = conversionKey(*geom, kind);
+  auto inserted = insertEntry(key, new cache_entry(geom, kind, converted), cost);
+  Trace::instant("cache", inserted ? "CGALCache conversion insert" : "CGALCache conversion insert failed", "id", key);
+  return inserted;
+}
+
+// Conversions of geometries which are gone can never be returned again.
+void CGALCache::removeExpiredConversions()
+{
+  std::vector<std::string> expired;
+  this->cache.forEach([&](const std::string& id, const cache_entry& entry, size_t /*cost*/) {
+    if (entry.converted && entry.source.expired()) expired.push_back(id);
+  });
+  for (const auto& id : expired) this->cache.remove(id);
+}
+
+// Inserts an entry, dropping expired conversions first if it would
+// otherwise evict live entries.
+bool CGALCache::insertEntry(const std::string& key, cache_entry *entry, size_t cost)
+{
+  if (this->cache.totalCost() + cost > this->cache.maxCost()) removeExpiredConversions();
+  return this->cache.insert(key, entry, cost);
+}
+
 size_t CGALCache::size() const
 {
   return cache.size();
@@ -45,6 +193,21 @@ size_t CGALCache::totalCost() const
   return cache.totalCost();
 }
 
+std::map<std::string, CacheUsage> CGALCache::usageByKind() const
+{
+  std::map<std::string, CacheUsage> usage;
+  this->cache.forEach([&](const std::string& /*id*/, const cache_entry& entry, size_t cost) {
+    std::string kind;
+    if (entry.converted) kind = "conversion to " + entry.conversion;
+    else if (entry.parts) kind = "convex decomposition";
+    else if (entry.hull) kind = "hull";
+    else kind = entry.N ? geometryKind(*entry.N) : "empty";
+    usage[kind].entries++;
+    usage[kind].cost += cost;
+  });
+  return usage;
+}
+
 size_t CGALCache::maxSizeMB() const
 {
   return this->cache.maxCost() / (1024ul * 1024ul);
@@ -64,6 +227,9 @@ void CGALCache::print()
 {
   LOG(message_group::None, Location::NONE, "", "CGAL Polyhedrons in cache: %1$d", this->cache.size());
   LOG(message_group::None, Location::NONE, "", "CGAL cache size in bytes: %1$d", this->cache.totalCost());
+  for (const auto& [kind, usage] : usageByKind()) {
+    LOG(message_group::None, Location::NONE, "", "   %1$s: %2$d entries, %3$d bytes", kind, usage.entries, usage.cost);
+  }
 }
 
 CGALCache::cache_entry::cache_entry(const shared_ptr<const Geometry>& N)
@@ -71,3 +237,19 @@ CGALCache::cache_entry::cache_entry(const shared_ptr<const Geometry>& N)
 {
   if (print_messages_stack.size() > 0) this->msg = print_messages_stack.back();
 }
+
+CGALCache::cache_entry::cache_entry(const PolygonList& decompositionSource, const shared_ptr<const ConvexParts>& parts)
+  : decompositionSource(decompositionSource), parts(parts)
+{
+}
+
+CGALCache::cache_entry::cache_entry(std::vector<double> hullOffsets, const shared_ptr<const HullFaces>& hull)
+  : hullOffsets(std::move(hullOffsets)), hull(hull)
+{
+}
+
+CGALCache::cache_entry::cache_entry(const shared_ptr<const Geometry>& source, const std::string& conversion,
+                                     const shared_ptr<const void>& converted)
+  : source(source), conversion(conversion), converted(converted)
+{
+}
@@ -1,9 +1,15 @@
 #pragma once
 
 #include "Cache.h"
+#include "linalg.h"
 #include "memory.h"
+#include "PolygonList.h"
+
+#include <map>
+#include <vector>
 
 class Geometry;
+class PolySet;
 
 /*!
  */
@@ -18,8 +24,52 @@ public:
   bool contains(const std::string& id) const { return this->cache.contains(id); }
   shared_ptr<const Geometry> get(const std::string& id) const;
   bool insert(const std::string& id, const shared_ptr<const Geometry>& N);
+
+  // Vertices of the convex parts a Minkowski operand was decomposed into.
+  // The polygons of the operand are stored along and compared on lookup.
+  using ConvexParts = std::vector<std::vector<Vector3d>>;
+  shared_ptr<const ConvexParts> getDecomposition(const PolySet& ps) const;
+  bool insertDecomposition(const PolySet& ps, const shared_ptr<const ConvexParts>& parts);
+
+  // Hulls of point clouds as faces indexing into the points, each face
+  // prefixed by its corner count. A hull doesn't change when its points are
+  // translated, so translated copies of a point cloud share an entry.
+  using HullFaces = std::vector<int>;
+  shared_ptr<const HullFaces> getHull(const std::vector<Vector3d>& points) const;
+  bool insertHull(const std::vector<Vector3d>& points, const shared_ptr<const HullFaces>& faces);
+
+  // Representations geometries were converted to, stored under the kind of
+  // conversion and the address of the geometry. They are only returned while
+  // that geometry is alive, since shared geometries are immutable, and are
+  // removed once it is gone.
+  shared_ptr<const void> getConversion(const shared_ptr<const Geometry>& geom, const std::string& kind);
+  bool insertConversion(const shared_ptr<const Geometry>& geom, const std::string& kind,
+                        const shared_ptr<const void>& converted, size_t cost);
+
+  // Returns the cached conversion of geom of the given kind, or the result of
+  // convert(), which is cached at cost(result) if anyone else holds geom.
+  template <typename T, typename Convert, typename Cost>
+  shared_ptr<const T> convert(const shared_ptr<const Geometry>& geom, const std::string& kind,
+                              Convert&& convert, Cost&& cost)
+  {
+    if (auto converted = getConversion(geom, kind)) return std::static_pointer_cast<const T>(converted);
+    shared_ptr<const T> converted = convert();
+    if (converted && geom.use_count() > 1) insertConversion(geom, kind, converted, cost(*converted));
+    return converted;
+  }
+
+  template <typename T, typename Convert>
+  shared_ptr<const T> convert(const shared_ptr<const Geometry>& geom, const std::string& kind, Convert&& convert)
+  {
+    return this->convert<T>(geom, kind, std::forward<Convert>(convert), [](const T& converted) {
+      return converted.memsize();
+    });
+  }
+
   size_t size() const;
   size_t totalCost() const;
+  // Entries and their cost by kind of geometry, decomposition or conversion
+  std::map<std::string, CacheUsage> usageByKind() const;
   size_t maxSizeMB() const;
   void setMaxSizeMB(size_t limit);
   void clear();
@@ -28,11 +78,30 @@ public:
 private:
   static CGALCache *inst;
 
+  static std::string decompositionKey(const PolySet& ps);
+  static std::string conversionKey(const Geometry& geom, const std::string& kind);
+  static std::vector<double> hullOffsets(const std::vector<Vector3d>& points);
+  static std::string hullKey(const std::vector<double>& offsets);
+
   struct cache_entry {
     shared_ptr<const Geometry> N;
+    PolygonList decompositionSource;
+    shared_ptr<const ConvexParts> parts;
+    std::vector<double> hullOffsets;
+    shared_ptr<const HullFaces> hull;
+    std::weak_ptr<const Geometry> source;
+    std::string conversion;
+    shared_ptr<const void> converted;
     std::string msg;
     cache_entry(const shared_ptr<const Geometry>& N);
+    cache_entry(const PolygonList& decompositionSource, const shared_ptr<const ConvexParts>& parts);
+    cache_entry(std::vector<double> hullOffsets, const shared_ptr<const HullFaces>& hull);
+    cache_entry(const shared_ptr<const Geometry>& source, const std::string& conversion,
+                const shared_ptr<const void>& converted);
   };
 
+  void removeExpiredConversions();
+  bool insertEntry(const std::string& key, cache_entry *entry, size_t cost);
+
   Cache<std::string, cache_entry> cache;
 };
@@ -262,14 +262,50 @@ std::string CGALHybridPolyhedron::dump() const
   // return OpenSCAD::dump_svg(toPolySet());
 }
 
+namespace {
+
+using ApproximateKernel = CGAL_HybridKernel3::Approximate_kernel;
+using ExactKernel = CGAL_HybridKernel3::Exact_kernel;
+
+// Rationals converted from doubles need a limb or two for each of their
+// numerator and denominator.
+constexpr size_t limbsPerRational = 4;
+
+// Estimated memory of the lazily evaluated representation of a kernel object
+// with the given number of coordinates: a vtable pointer, a reference count,
+// the interval approximation, and the exact object once it has been needed.
+template <typename Approximate, typename Exact>
+constexpr size_t lazyMemsize(size_t numbers)
+{
+  return sizeof(void *) + sizeof(unsigned int) + sizeof(Approximate) + sizeof(Exact) +
+         numbers * limbsPerRational * sizeof(mp_limb_t);
+}
+
+constexpr size_t lazyPointMemsize = lazyMemsize<ApproximateKernel::Point_3, ExactKernel::Point_3>(3);
+constexpr size_t lazyPlaneMemsize = lazyMemsize<ApproximateKernel::Plane_3, ExactKernel::Plane_3>(4);
+
+} // namespace
+
+/*!
+   CGAL doesn't report the size of the lazily evaluated points and planes of
+   the hybrid kernel, nor of the construction history they may keep, so each
+   of them is charged lazyPointMemsize or lazyPlaneMemsize.
+ */
 size_t CGALHybridPolyhedron::memsize() const
 {
   size_t total = sizeof(CGALHybridPolyhedron);
   if (auto mesh = getMesh()) {
-    total += numFacets() * 3 * sizeof(size_t);
-    total += numVertices() * sizeof(point_t);
+    // Surface_mesh keeps the connectivity and a removal flag of each element,
+    // including removed elements until the mesh is collected.
+    total += mesh->num_vertices() * (sizeof(CGAL_HybridMesh::Halfedge_index) + sizeof(bool) + lazyPointMemsize);
+    total += mesh->num_halfedges() * 4 * sizeof(CGAL_HybridMesh::Halfedge_index);
+    total += mesh->num_edges() * sizeof(bool);
+    total += mesh->num_faces() * (sizeof(CGAL_HybridMesh::Halfedge_index) + sizeof(bool));
   } else if (auto nef = getNefPolyhedron()) {
     total += nef->bytes();
+    total += (nef->number_of_vertices() + nef->number_of_halfedges()) * lazyPointMemsize;
+    total += (nef->number_of_halffacets() + nef->number_of_shalfedges() + nef->number_of_shalfloops()) *
+             lazyPlaneMemsize;
   }
   return total;
 }
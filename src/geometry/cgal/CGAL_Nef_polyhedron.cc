@@ -4,6 +4,8 @@
 #include "printutils.h"
 #include "svg.h"
 
+#include <unordered_set>
+
 CGAL_Nef_polyhedron::CGAL_Nef_polyhedron(const CGAL_Nef_polyhedron3 *p)
 {
   if (p) p3.reset(p);
@@ -53,13 +55,64 @@ CGAL_Nef_polyhedron& CGAL_Nef_polyhedron::minkowski(const CGAL_Nef_polyhedron& o
   return *this;
 }
 
+namespace {
+
+// Adds up the memory of distinct rational numbers. Copies of a Gmpq share
+// their number, which is then only counted once.
+class NumberMemsize
+{
+public:
+  void add(const CGAL::Gmpq& q) {
+    if (!this->seen.insert(q.mpq()).second) return;
+    const auto limbs = mpq_numref(q.mpq())->_mp_alloc + mpq_denref(q.mpq())->_mp_alloc;
+    // The shared representation holds the mpq_t and a reference count
+    this->bytes += sizeof(mpq_t) + sizeof(unsigned int) + limbs * sizeof(mp_limb_t);
+  }
+  template <typename Point> void addPoint(const Point& p) {
+    add(p.x()); add(p.y()); add(p.z());
+  }
+  template <typename Plane> void addPlane(const Plane& h) {
+    add(h.a()); add(h.b()); add(h.c()); add(h.d());
+  }
+
+  size_t bytes = 0;
+
+private:
+  std::unordered_set<mpq_srcptr> seen;
+};
+
+} // namespace
+
+/*!
+   Nef_polyhedron_3::bytes() only counts the structure of the polyhedron. The
+   coordinates of its points, planes and sphere maps are rationals whose limbs
+   GMP allocates separately, and which often take more memory than the
+   structure, so they are added up here. That visits the whole polyhedron, so
+   the result is kept until p3 changes.
+ */
 size_t CGAL_Nef_polyhedron::memsize() const
 {
   if (this->isEmpty()) return 0;
+  if (this->memsizeSource.lock() == this->p3) return this->memsizeBytes;
 
   auto memsize = sizeof(CGAL_Nef_polyhedron);
-  memsize += const_cast<CGAL_Nef_polyhedron3&>(*this->p3).bytes();
-  return memsize;
+  const auto& N = *this->p3;
+  memsize += const_cast<CGAL_Nef_polyhedron3&>(N).bytes();
+
+  NumberMemsize numbers;
+  CGAL_Nef_polyhedron3::Vertex_const_iterator vi;
+  CGAL_forall_vertices(vi, N) numbers.addPoint(vi->point());
+  CGAL_Nef_polyhedron3::Halfedge_const_iterator ei;
+  CGAL_forall_halfedges(ei, N) numbers.addPoint(ei->point());
+  CGAL_Nef_polyhedron3::Halffacet_const_iterator fi;
+  CGAL_forall_halffacets(fi, N) numbers.addPlane(fi->plane());
+  CGAL_Nef_polyhedron3::SHalfedge_const_iterator sei;
+  CGAL_forall_shalfedges(sei, N) numbers.addPlane(sei->circle());
+  CGAL_Nef_polyhedron3::SHalfloop_const_iterator sli;
+  CGAL_forall_shalfloops(sli, N) numbers.addPlane(sli->circle());
+  this->memsizeSource = this->p3;
+  this->memsizeBytes = memsize + numbers.bytes;
+  return this->memsizeBytes;
 }
 
 bool CGAL_Nef_polyhedron::isEmpty() const
@@ -39,4 +39,10 @@ public:
   void resize(const Vector3d& newsize, const Eigen::Matrix<bool, 3, 1>& autosize) override;
 
   shared_ptr<const CGAL_Nef_polyhedron3> p3;
+
+private:
+  // memsize() of memsizeSource, which p3 is as long as it is unchanged.
+  // p3 is never modified in place, so a different object means a new size.
+  mutable std::weak_ptr<const CGAL_Nef_polyhedron3> memsizeSource;
+  mutable size_t memsizeBytes = 0;
 };
@@ -1,6 +1,8 @@
 #include "Polygon2d.h"
 #include "PolySet.h"
 #include "printutils.h"
+#include "EarClipping.h"
+#include "Trace.h"
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
 #include <CGAL/Triangulation_face_base_with_info_2.h>
@@ -111,8 +113,28 @@ double Polygon2d::area() const
 PolySet *Polygon2d::tessellate() const
 {
   PRINTDB("Polygon2d::tessellate(): %d outlines", this->outlines().size());
+  Trace::Span span("geometry", "Polygon2d::tessellate");
   auto polyset = new PolySet(*this);
 
+  // Sanitized polygons don't intersect themselves, so ear clipping can
+  // usually triangulate them, much faster than a constrained triangulation.
+  if (this->sanitized) {
+    std::vector<IndexedTriangle> triangles;
+    if (EarClipping::triangulate(*this, triangles)) {
+      span.arg("method", "ear clipping");
+      for (const auto& outline : this->outlines()) {
+        for (const auto& v : outline.vertices) polyset->add_vertex(Vector3d(v[0], v[1], 0));
+      }
+      polyset->reserve(triangles.size(), 3 * triangles.size());
+      for (const auto& t : triangles) {
+        polyset->append_poly();
+        for (int i = 0; i < 3; ++i) polyset->append_index(t[i]);
+      }
+      return polyset;
+    }
+  }
+  span.arg("method", "constrained Delaunay");
+
   Polygon2DCGAL::CDT cdt; // Uses a constrained Delaunay triangulator.
 
   try {
@@ -0,0 +1,206 @@
+// this file is split into many separate cgalutils* files
+// in order to workaround gcc 4.9.1 crashing on systems with only 2GB of RAM
+
+#ifdef ENABLE_CGAL
+
+#include "cgalutils.h"
+#include "CGALCache.h"
+#include "node.h"
+#include "printutils.h"
+#include "progress.h"
+#include "Trace.h"
+
+#include <CGAL/boost/graph/helpers.h>
+#include <CGAL/Polygon_mesh_processing/corefinement.h>
+#include <CGAL/Polygon_mesh_processing/orientation.h>
+#include <CGAL/Polygon_mesh_processing/self_intersections.h>
+#include <CGAL/Polygon_mesh_processing/triangulate_faces.h>
+#include <CGAL/Surface_mesh.h>
+
+#include <queue>
+
+namespace PMP = CGAL::Polygon_mesh_processing;
+
+namespace CGALUtils {
+
+/*
+   Double-precision CSG.
+
+   Operands are converted to triangle meshes with double coordinates and
+   combined with corefinement. Predicates are evaluated exactly (filtered
+   interval arithmetic falling back to exact numbers), so coplanar and
+   touching faces are classified robustly, while new vertices are rounded to
+   doubles. Triangle pairs are culled with a box intersection tree before any
+   predicate is evaluated.
+
+   Only closed, non self-intersecting meshes bounding a volume are handled.
+   Anything else makes the functions below return false, and the caller falls
+   back to the exact backends.
+ */
+
+namespace {
+
+using DoubleMesh = CGAL::Surface_mesh<CGAL::Point_3<CGAL::Epick>>;
+using DoubleMeshPtr = std::shared_ptr<DoubleMesh>;
+
+// Approximate memory use of mesh: its points and the indices Surface_mesh
+// keeps for each vertex, halfedge and face.
+size_t meshMemsize(const DoubleMesh& mesh)
+{
+  return sizeof(DoubleMesh) + mesh.number_of_vertices() * (sizeof(DoubleMesh::Point) + sizeof(uint32_t)) +
+         mesh.number_of_halfedges() * 4 * sizeof(uint32_t) + mesh.number_of_faces() * sizeof(uint32_t);
+}
+
+// Returns nullptr if geom can't be represented as a valid volume.
+DoubleMeshPtr createDoubleMeshFromGeometry(const shared_ptr<const Geometry>& geom)
+{
+  // Operations write their result into their operands, so they get copies
+  // of the meshes, which are cheaper than converting and validating again.
+  auto mesh = CGALCache::instance()->convert<DoubleMesh>(
+    geom, "double mesh", [&]() -> shared_ptr<const DoubleMesh> {
+    Trace::Span span("conversion", "createDoubleMeshFromGeometry");
+    auto ps = getGeometryAsPolySet(geom);
+    if (!ps) return nullptr;
+
+    auto mesh = std::make_shared<DoubleMesh>();
+    createMeshFromPolySet(*ps, *mesh);
+    if (mesh->is_empty()) return mesh;
+    // Faces which would make the mesh non-manifold are dropped by
+    // createMeshFromPolySet, which leaves it open.
+    if (!CGAL::is_closed(*mesh)) return nullptr;
+    if (!CGAL::is_triangle_mesh(*mesh) && !PMP::triangulate_faces(*mesh)) return nullptr;
+    if (PMP::does_self_intersect(*mesh) || !PMP::does_bound_a_volume(*mesh)) return nullptr;
+    span.arg("faces", mesh->number_of_faces());
+    return mesh;
+  }, meshMemsize);
+  return mesh ? std::make_shared<DoubleMesh>(*mesh) : nullptr;
+}
+
+// Rounding intersection points to doubles may fold thin slivers over; such
+// results are rejected rather than returned as broken geometry.
+bool isValidResult(const DoubleMesh& mesh)
+{
+  return mesh.is_empty() || (CGAL::is_closed(mesh) && !PMP::does_self_intersect(mesh));
+}
+
+shared_ptr<const Geometry> createPolySetFromDoubleMesh(const DoubleMesh& mesh)
+{
+  if (mesh.is_empty()) return nullptr;
+  auto ps = std::make_shared<PolySet>(3);
+  createPolySetFromMesh(mesh, *ps);
+  return ps;
+}
+
+} // namespace
+
+bool applyUnion3DDouble(
+  const Geometry::Geometries::const_iterator& chbegin,
+  const Geometry::Geometries::const_iterator& chend,
+  shared_ptr<const Geometry>& result)
+{
+  Trace::Span span("csg", "applyUnion3DDouble");
+  span.arg("children", static_cast<size_t>(std::distance(chbegin, chend)));
+  using QueueItem = std::pair<DoubleMeshPtr, int>;
+  struct QueueItemGreater {
+    // stable sort for priority_queue by facets, then progress mark
+    bool operator()(const QueueItem& lhs, const QueueItem& rhs) const
+    {
+      size_t l = lhs.first->number_of_faces();
+      size_t r = rhs.first->number_of_faces();
+      return (l > r) || (l == r && lhs.second > rhs.second);
+    }
+  };
+
+  try {
+    std::vector<QueueItem> queueItems;
+    for (auto it = chbegin; it != chend; ++it) {
+      const auto& chgeom = it->second;
+      if (!chgeom || chgeom->isEmpty()) continue;
+      auto mesh = createDoubleMeshFromGeometry(chgeom);
+      if (!mesh) return false;
+      if (mesh->is_empty()) continue;
+      queueItems.emplace_back(mesh, it->first ? it->first->progress_mark : -1);
+    }
+    std::priority_queue<QueueItem, std::vector<QueueItem>, QueueItemGreater>
+    q(queueItems.begin(), queueItems.end());
+
+    progress_tick();
+    while (q.size() > 1) {
+      auto p1 = q.top();
+      q.pop();
+      auto p2 = q.top();
+      q.pop();
+      Trace::Span step("csg", "applyUnion3DDouble step");
+      // Write the result in place of the biggest operand.
+      if (!PMP::corefine_and_compute_union(*p2.first, *p1.first, *p2.first)) return false;
+      q.emplace(p2.first, -1);
+      progress_tick();
+    }
+
+    if (q.empty()) {
+      result = nullptr;
+      return true;
+    }
+    if (!isValidResult(*q.top().first)) return false;
+    result = createPolySetFromDoubleMesh(*q.top().first);
+    return true;
+  } catch (const std::exception& e) {
+    PRINTDB("Double-precision union failed, falling back: %s", e.what());
+  }
+  return false;
+}
+
+bool applyOperator3DDouble(const Geometry::Geometries& children, OpenSCADOperator op,
+                           shared_ptr<const Geometry>& result)
+{
+  if (op != OpenSCADOperator::INTERSECTION && op != OpenSCADOperator::DIFFERENCE) return false;
+
+  Trace::Span span("csg", "applyOperator3DDouble");
+  span.arg("children", children.size());
+  DoubleMeshPtr N;
+  bool foundFirst = false;
+
+  try {
+    for (const auto& item : children) {
+      DoubleMeshPtr chN;
+      if (item.second && !item.second->isEmpty()) {
+        chN = createDoubleMeshFromGeometry(item.second);
+        if (!chN) return false;
+      }
+
+      // Initialize N with first expected geometric object
+      if (!foundFirst) {
+        N = chN;
+        foundFirst = true;
+        continue;
+      }
+
+      // Intersecting something with nothing results in nothing
+      if (!chN || chN->is_empty()) {
+        if (op == OpenSCADOperator::INTERSECTION) N = nullptr;
+        continue;
+      }
+
+      // empty op <something> => empty
+      if (!N || N->is_empty()) continue;
+
+      Trace::Span step("csg", "applyOperator3DDouble step");
+      bool success = op == OpenSCADOperator::INTERSECTION
+        ? PMP::corefine_and_compute_intersection(*N, *chN, *N)
+        : PMP::corefine_and_compute_difference(*N, *chN, *N);
+      if (!success) return false;
+      if (item.first) item.first->progress_report();
+    }
+
+    if (N && !isValidResult(*N)) return false;
+    result = N ? createPolySetFromDoubleMesh(*N) : nullptr;
+    return true;
+  } catch (const std::exception& e) {
+    PRINTDB("Double-precision CSG failed, falling back: %s", e.what());
+  }
+  return false;
+}
+
+}  // namespace CGALUtils
+
+#endif // ENABLE_CGAL
@@ -7,8 +7,12 @@
 #include "cgalutils.h"
 #include "PolySet.h"
 #include "printutils.h"
+#include "CGALCache.h"
 #include "CGALHybridPolyhedron.h"
+#include "Feature.h"
 #include "node.h"
+#include "parallel.h"
+#include "Trace.h"
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/normal_vector_newell_3.h>
@@ -22,7 +26,10 @@
 
 #include "memory.h"
 
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <numeric>
 #include <queue>
 #include <unordered_set>
 
@@ -48,9 +55,18 @@ shared_ptr<const Geometry> applyMinkowskiHybrid(const Geometry::Geometries& chil
     while (++it != children.end()) {
       operands[1] = it->second;
 
-      std::list<shared_ptr<Hybrid_Polyhedron>> P[2];
+      // Vertices of the convex parts of each operand
+      std::vector<std::vector<Hull_kernel::Point_3>> points[2];
       std::list<shared_ptr<Hull_Polyhedron>> result_parts;
 
+      CGAL::Cartesian_converter<CGAL_HybridKernel3, Hull_kernel> conv;
+      auto addPart = [&](std::vector<Hull_kernel::Point_3>& part, const Hybrid_Polyhedron& poly) {
+          part.reserve(poly.size_of_vertices());
+          for (auto pi = poly.vertices_begin(); pi != poly.vertices_end(); ++pi) {
+            part.push_back(conv(pi->point()));
+          }
+        };
+
       for (size_t i = 0; i < 2; ++i) {
         auto poly = make_shared<Hybrid_Polyhedron>();
 
@@ -70,8 +86,23 @@ shared_ptr<const Geometry> applyMinkowskiHybrid(const Geometry::Geometries& chil
         if ((ps && ps->is_convex()) ||
             (!ps && CGALUtils::is_weakly_convex(*poly))) {
           PRINTDB("Minkowski: child %d is convex and %s", i % (ps?"PolySet":"Hybrid"));
-          P[i].push_back(poly);
+          addPart(points[i].emplace_back(), *poly);
         } else {
+          // The same operand, e.g. a rounding tool, is often used in several
+          // minkowski() calls.
+          auto keyPs = ps ? ps : CGALUtils::getGeometryAsPolySet(operands[i]);
+          if (keyPs) {
+            if (auto parts = CGALCache::instance()->getDecomposition(*keyPs)) {
+              PRINTDB("Minkowski: child %d is nonconvex, reusing its %d convex parts", i % parts->size());
+              for (const auto& part : *parts) {
+                auto& partPoints = points[i].emplace_back();
+                partPoints.reserve(part.size());
+                for (const auto& v : part) partPoints.push_back(vector_convert<Hull_kernel::Point_3>(v));
+              }
+              continue;
+            }
+          }
+
           PRINTDB("Minkowski: child %d is nonconvex, decomposing...", i);
           shared_ptr<Hybrid_Nef> decomposed_nef;
 
@@ -88,62 +119,67 @@ shared_ptr<const Geometry> applyMinkowskiHybrid(const Geometry::Geometries& chil
           Hybrid_Nef::Volume_const_iterator ci = ++decomposed_nef->volumes_begin();
           for (; ci != decomposed_nef->volumes_end(); ++ci) {
             if (ci->mark()) {
-              auto poly = make_shared<Hybrid_Polyhedron>();
-              decomposed_nef->convert_inner_shell_to_polyhedron(ci->shells_begin(), *poly);
-              P[i].push_back(poly);
+              Hybrid_Polyhedron poly;
+              decomposed_nef->convert_inner_shell_to_polyhedron(ci->shells_begin(), poly);
+              addPart(points[i].emplace_back(), poly);
             }
           }
 
-          PRINTDB("Minkowski: decomposed into %d convex parts", P[i].size());
+          PRINTDB("Minkowski: decomposed into %d convex parts", points[i].size());
           t.stop();
           PRINTDB("Minkowski: decomposition took %f s", t.time());
+
+          if (keyPs) {
+            auto parts = make_shared<CGALCache::ConvexParts>();
+            for (const auto& part : points[i]) {
+              auto& vertices = parts->emplace_back();
+              vertices.reserve(part.size());
+              for (const auto& p : part) vertices.push_back(vector_convert<Vector3d>(p));
+            }
+            CGALCache::instance()->insertDecomposition(*keyPs, parts);
+          }
         }
       }
 
-      std::vector<Hull_kernel::Point_3> points[2];
-      std::vector<Hull_kernel::Point_3> minkowski_points;
+      // With fast-minkowski, hulls of the parts, to find their Minkowski sum
+      // vertices without summing every pair of part vertices. Flat parts have none.
+      const bool fastMinkowski = Feature::ExperimentalFastMinkowski.is_enabled();
+      std::vector<ConvexMinkowskiOperand> hulls[2];
+      std::vector<bool> hasHull[2];
 
-      CGAL::Cartesian_converter<CGAL_HybridKernel3, Hull_kernel> conv;
-
-      for (size_t i = 0; i < P[0].size(); ++i) {
-        for (size_t j = 0; j < P[1].size(); ++j) {
-          t.start();
-          points[0].clear();
-          points[1].clear();
-
-          for (int k = 0; k < 2; ++k) {
-            auto it = P[k].begin();
-            std::advance(it, k == 0?i:j);
-
-            auto& poly = *it;
-            points[k].reserve(poly->size_of_vertices());
-
-            for (auto pi = poly->vertices_begin(); pi != poly->vertices_end(); ++pi) {
-              Hybrid_Polyhedron::Point_3 const& p = pi->point();
-              points[k].push_back(conv(p));
-            }
-          }
+      for (int k = 0; k < 2; ++k) {
+        for (const auto& partPoints : points[k]) {
+          hasHull[k].push_back(fastMinkowski && createConvexMinkowskiOperand(partPoints, hulls[k].emplace_back()));
+        }
+      }
 
-          minkowski_points.clear();
-          minkowski_points.reserve(points[0].size() * points[1].size());
-          for (size_t i = 0; i < points[0].size(); ++i) {
-            for (size_t j = 0; j < points[1].size(); ++j) {
-              minkowski_points.push_back(points[0][i] + (points[1][j] - CGAL::ORIGIN));
+      // Pair hulls are independent, so with parallel-minkowski they are
+      // computed on several threads. Results are kept in pair order.
+      const size_t numPairs = points[0].size() * points[1].size();
+      std::vector<shared_ptr<Hull_Polyhedron>> pairHulls(numPairs);
+      std::vector<double> pairSeconds(numPairs);
+      auto hullPair = [&](size_t pair) {
+          const size_t i = pair / points[1].size();
+          const size_t j = pair % points[1].size();
+          Trace::Span span("minkowski", "hull pair");
+          CGAL::Timer pairTimer;
+          pairTimer.start();
+
+          std::vector<Hull_kernel::Point_3> minkowski_points;
+          if (hasHull[0][i] && hasHull[1][j]) {
+            convexMinkowskiPoints(hulls[0][i], hulls[1][j], minkowski_points);
+          } else {
+            minkowski_points.reserve(points[0][i].size() * points[1][j].size());
+            for (const auto& p : points[0][i]) {
+              for (const auto& q : points[1][j]) {
+                minkowski_points.push_back(p + (q - CGAL::ORIGIN));
+              }
             }
           }
-
-          if (minkowski_points.size() <= 3) {
-            t.stop();
-            continue;
-          }
+          span.arg("points", minkowski_points.size());
+          if (minkowski_points.size() <= 3) return;
 
           auto result = make_shared<Hull_Polyhedron>();
-          t.stop();
-          PRINTDB("Minkowski: Point cloud creation (%d ⨉ %d -> %d) took %f ms", points[0].size() % points[1].size() % minkowski_points.size() % (t.time() * 1000));
-          t.reset();
-
-          t.start();
-
           CGAL::convex_hull_3(minkowski_points.begin(), minkowski_points.end(), *result);
 
           std::vector<Hull_kernel::Point_3> strict_points;
@@ -185,13 +221,33 @@ shared_ptr<const Geometry> applyMinkowskiHybrid(const Geometry::Geometries& chil
           result->clear();
           CGAL::convex_hull_3(strict_points.begin(), strict_points.end(), *result);
 
+          pairTimer.stop();
+          pairSeconds[pair] = pairTimer.time();
+          pairHulls[pair] = result;
+        };
 
-          t.stop();
-          PRINTDB("Minkowski: Computing convex hull took %f s", t.time());
-          t.reset();
-
-          result_parts.push_back(result);
-        }
+      t.start();
+      size_t numThreads = 1;
+      if (Feature::ExperimentalParallelMinkowski.is_enabled() && !Parallel::isWorker()) {
+        numThreads = std::min<size_t>(Parallel::concurrency(), numPairs);
+      }
+      if (numThreads > 1) {
+        std::atomic<size_t> nextPair{0};
+        Parallel::run(numThreads, [&](size_t) {
+            for (size_t pair = nextPair++; pair < numPairs; pair = nextPair++) hullPair(pair);
+          });
+      } else {
+        for (size_t pair = 0; pair < numPairs; ++pair) hullPair(pair);
+      }
+      t.stop();
+      PRINTDB("Minkowski: Computing %d pair hulls on %d threads took %f s (sum %f s, max %f s)",
+              numPairs % numThreads % t.time() %
+              std::accumulate(pairSeconds.begin(), pairSeconds.end(), 0.0) %
+              (numPairs ? *std::max_element(pairSeconds.begin(), pairSeconds.end()) : 0.0));
+      t.reset();
+
+      for (const auto& result : pairHulls) {
+        if (result) result_parts.push_back(result);
       }
 
       if (it != std::next(children.begin())) operands[0].reset();
@@ -7,6 +7,7 @@
 #include "CGALHybridPolyhedron.h"
 #include "node.h"
 #include "progress.h"
+#include "Trace.h"
 
 Location getLocation(const std::shared_ptr<const AbstractNode>& node)
 {
@@ -19,6 +20,8 @@ shared_ptr<CGALHybridPolyhedron> applyUnion3DHybrid(
   const Geometry::Geometries::const_iterator& chbegin,
   const Geometry::Geometries::const_iterator& chend)
 {
+  Trace::Span span("csg", "applyUnion3DHybrid");
+  span.arg("children", static_cast<size_t>(std::distance(chbegin, chend)));
   using QueueItem = std::pair<shared_ptr<CGALHybridPolyhedron>, int>;
   struct QueueItemGreater {
     // stable sort for priority_queue by facets, then progress mark
@@ -62,6 +65,7 @@ shared_ptr<CGALHybridPolyhedron> applyUnion3DHybrid(
       auto p2 = q.top();
       q.pop();
       assert(p1.first->numFacets() <= p2.first->numFacets());
+      Trace::Span step("csg", "applyUnion3DHybrid step");
       // Modify in-place the biggest polyhedron.
       *p2.first += *p1.first;
       q.emplace(p2.first, -1);
@@ -85,6 +89,8 @@ shared_ptr<CGALHybridPolyhedron> applyUnion3DHybrid(
  */
 shared_ptr<CGALHybridPolyhedron> applyOperator3DHybrid(const Geometry::Geometries& children, OpenSCADOperator op)
 {
+  Trace::Span span("csg", "applyOperator3DHybrid");
+  span.arg("children", children.size());
   shared_ptr<CGALHybridPolyhedron> N;
 
   assert(op != OpenSCADOperator::UNION && "use applyUnion3D() instead of applyOperator3D()");
@@ -113,6 +119,7 @@ shared_ptr<CGALHybridPolyhedron> applyOperator3DHybrid(const Geometry::Geometrie
       // empty op <something> => empty
       if (!N || N->isEmpty()) continue;
 
+      Trace::Span step("csg", "applyOperator3DHybrid step");
       switch (op) {
       case OpenSCADOperator::INTERSECTION:
         *N *= *chN;
@@ -9,6 +9,7 @@
 #include "PolySet.h"
 #include "printutils.h"
 #include "progress.h"
+#include "Trace.h"
 #include "CGALHybridPolyhedron.h"
 #include "node.h"
 
@@ -21,9 +22,11 @@
 
 #include <CGAL/convex_hull_3.h>
 
+#include "CGALCache.h"
 #include "memory.h"
 #include "Reindexer.h"
 #include "GeometryUtils.h"
+#include "QuickHull.h"
 
 #include <map>
 #include <queue>
@@ -37,6 +40,12 @@ namespace CGALUtils {
  */
 shared_ptr<const Geometry> applyOperator3D(const Geometry::Geometries& children, OpenSCADOperator op)
 {
+  Trace::Span span("csg", "applyOperator3D");
+  span.arg("children", children.size());
+  if (Feature::ExperimentalDoubleCsg.is_enabled()) {
+    shared_ptr<const Geometry> result;
+    if (applyOperator3DDouble(children, op, result)) return result;
+  }
   if (Feature::ExperimentalFastCsg.is_enabled()) {
     return applyOperator3DHybrid(children, op);
   }
@@ -74,6 +83,7 @@ shared_ptr<const Geometry> applyOperator3D(const Geometry::Geometries& children,
       // empty op <something> => empty
       if (!N || N->isEmpty()) continue;
 
+      Trace::Span step("csg", "applyOperator3D step");
       switch (op) {
       case OpenSCADOperator::INTERSECTION:
         *N *= *chN;
@@ -106,6 +116,12 @@ shared_ptr<const Geometry> applyOperator3D(const Geometry::Geometries& children,
 shared_ptr<const Geometry> applyUnion3D(
   Geometry::Geometries::iterator chbegin, Geometry::Geometries::iterator chend)
 {
+  Trace::Span span("csg", "applyUnion3D");
+  span.arg("children", static_cast<size_t>(std::distance(chbegin, chend)));
+  if (Feature::ExperimentalDoubleCsg.is_enabled()) {
+    shared_ptr<const Geometry> result;
+    if (applyUnion3DDouble(chbegin, chend, result)) return result;
+  }
   if (Feature::ExperimentalFastCsg.is_enabled()) {
     return applyUnion3DHybrid(chbegin, chend);
   }
@@ -141,6 +157,7 @@ shared_ptr<const Geometry> applyUnion3D(
       q.pop();
       auto p2 = q.top();
       q.pop();
+      Trace::Span step("csg", "applyUnion3D step");
       q.emplace(make_shared<const CGAL_Nef_polyhedron>(*p1.first + *p2.first), -1);
       progress_tick();
     }
@@ -158,19 +175,83 @@ shared_ptr<const Geometry> applyUnion3D(
 
 
 
+namespace {
+
+// Appends the polygons of a face list indexing into points to result.
+void appendHullFaces(const CGALCache::HullFaces& faces, const std::vector<Vector3d>& points, PolySet& result)
+{
+  std::vector<int> vertexIndex(points.size(), -1);
+  for (size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+    result.append_poly();
+    for (int j = 1; j <= faces[i]; ++j) {
+      int& index = vertexIndex[faces[i + j]];
+      if (index < 0) index = result.add_vertex(points[faces[i + j]]);
+      result.append_index(index);
+    }
+  }
+}
+
+// Expresses the faces of hull as indices into points. Returns false if hull
+// has a vertex which isn't one of the points.
+bool getHullFaces(const PolySet& hull, Reindexer<Vector3d>& reindexer, size_t numPoints, CGALCache::HullFaces& faces)
+{
+  faces.reserve(hull.polygons.size() + hull.polygons.indices.size());
+  for (const auto& p : hull.polygons) {
+    faces.push_back(p.size());
+    for (const auto& v : p) {
+      size_t index = reindexer.lookup(v);
+      if (index >= numPoints) return false;
+      faces.push_back(index);
+    }
+  }
+  return true;
+}
+
+const PolySet *getSingleConvexPolySet(const Geometry::Geometries& children)
+{
+  const PolySet *single = nullptr;
+  for (const auto& item : children) {
+    if (!item.second || item.second->isEmpty()) continue;
+    if (single) return nullptr;
+    single = dynamic_cast<const PolySet *>(item.second.get());
+    if (!single) return nullptr;
+  }
+  // Only trust convexity known from construction; is_convex() would fall
+  // back to an approximate check for other meshes.
+  return single && bool(single->convexValue()) ? single : nullptr;
+}
+
+} // namespace
+
 bool applyHull(const Geometry::Geometries& children, PolySet& result)
 {
   using K = CGAL::Epick;
+  const bool fastHull = Feature::ExperimentalFastHull.is_enabled();
+
+  // A convex child, e.g. a primitive or an earlier hull, is its own hull.
+  if (fastHull) {
+    if (const auto *ps = getSingleConvexPolySet(children)) {
+      Trace::instant("geometry", "convex hull child");
+      CGALCache::HullFaces faces;
+      for (const auto& p : ps->polygons) {
+        faces.push_back(p.size());
+        for (size_t i = 0; i < p.size(); ++i) faces.push_back(p.index(i));
+      }
+      appendHullFaces(faces, ps->polygons.vertices, result);
+      return true;
+    }
+  }
+
   // Collect point cloud
-  Reindexer<K::Point_3> reindexer;
-  std::vector<K::Point_3> points;
+  Reindexer<Vector3d> reindexer;
+  std::vector<Vector3d> points;
   size_t pointsSaved = 0;
 
-  auto addPoint = [&](const auto& v) {
+  auto addPoint = [&](const Vector3d& v) {
       size_t s = reindexer.size();
       size_t idx = reindexer.lookup(v);
       if (idx == s) {
-        points.push_back(vector_convert<K::Point_3>(v));
+        points.push_back(v);
       } else {
         pointsSaved++;
       }
@@ -182,23 +263,28 @@ bool applyHull(const Geometry::Geometries& children, PolySet& result)
       if (!N->isEmpty()) {
         points.reserve(points.size() + N->p3->number_of_vertices());
         for (CGAL_Nef_polyhedron3::Vertex_const_iterator i = N->p3->vertices_begin(); i != N->p3->vertices_end(); ++i) {
-          addPoint(vector_convert<K::Point_3>(i->point()));
+          addPoint(vector_convert<Vector3d>(i->point()));
         }
       }
     } else if (auto hybrid = dynamic_pointer_cast<const CGALHybridPolyhedron>(chgeom)) {
       points.reserve(points.size() + hybrid->numVertices());
       hybrid->foreachVertexUntilTrue([&](auto& p) {
-          addPoint(vector_convert<K::Point_3>(p));
+          addPoint(vector_convert<Vector3d>(p));
           return false;
         });
     } else {
       const auto *ps = dynamic_cast<const PolySet *>(chgeom.get());
       if (ps) {
-        points.reserve(points.size() + ps->polygons.size() * 3);
-        for (const auto& p : ps->polygons) {
-          for (const auto& v : p) {
-            addPoint(vector_convert<K::Point_3>(v));
-          }
+        // Visit each used vertex once rather than once per corner. For
+        // children which are hulls themselves, these are just the hull
+        // vertices.
+        const auto& vertices = ps->polygons.vertices;
+        std::vector<bool> visited(vertices.size());
+        points.reserve(points.size() + vertices.size());
+        for (int index : ps->polygons.indices) {
+          if (visited[index]) continue;
+          visited[index] = true;
+          addPoint(vertices[index]);
         }
       }
     }
@@ -206,12 +292,40 @@ bool applyHull(const Geometry::Geometries& children, PolySet& result)
 
   if (points.size() <= 3) return false;
 
+  if (fastHull) {
+    if (auto faces = CGALCache::instance()->getHull(points)) {
+      appendHullFaces(*faces, points, result);
+      return true;
+    }
+  }
+  auto cacheResult = [&]() {
+      if (!fastHull) return;
+      auto faces = std::make_shared<CGALCache::HullFaces>();
+      if (!getHullFaces(result, reindexer, points.size(), *faces)) return;
+      CGALCache::instance()->insertHull(points, faces);
+    };
+
+  std::vector<Vector3d> candidates;
+  if (fastHull) {
+    candidates = QuickHull::filterInterior(points);
+    if (QuickHull::hull(candidates, result)) {
+      cacheResult();
+      return true;
+    }
+    PRINTDB("Falling back to exact hull of %d points", candidates.size());
+  } else {
+    candidates = points;
+  }
+
   // Apply hull
   bool success = false;
-  if (points.size() >= 4) {
+  if (candidates.size() >= 4) {
     try {
+      std::vector<K::Point_3> kernelPoints;
+      kernelPoints.reserve(candidates.size());
+      for (const auto& p : candidates) kernelPoints.push_back(vector_convert<K::Point_3>(p));
       CGAL::Polyhedron_3<K> r;
-      CGAL::convex_hull_3(points.begin(), points.end(), r);
+      CGAL::convex_hull_3(kernelPoints.begin(), kernelPoints.end(), r);
       PRINTDB("After hull vertices: %d", r.size_of_vertices());
       PRINTDB("After hull facets: %d", r.size_of_facets());
       PRINTDB("After hull closed: %d", r.is_closed());
@@ -221,6 +335,7 @@ bool applyHull(const Geometry::Geometries& children, PolySet& result)
       LOG(message_group::Error, Location::NONE, "", "CGAL error in applyHull(): %1$s", e.what());
     }
   }
+  if (success) cacheResult();
   return success;
 }
 
@@ -296,35 +411,39 @@ shared_ptr<const Geometry> applyMinkowski(const Geometry::Geometries& children)
         }
       }
 
-      std::vector<Hull_kernel::Point_3> points[2];
+      std::vector<std::vector<Hull_kernel::Point_3>> points[2];
+      // With fast-minkowski, hulls of the parts, to find their Minkowski sum
+      // vertices without summing every pair of part vertices. Flat parts have none.
+      const bool fastMinkowski = Feature::ExperimentalFastMinkowski.is_enabled();
+      std::vector<ConvexMinkowskiOperand> hulls[2];
+      std::vector<bool> hasHull[2];
       std::vector<Hull_kernel::Point_3> minkowski_points;
 
       CGAL::Cartesian_converter<CGAL_Kernel3, Hull_kernel> conv;
 
+      for (int k = 0; k < 2; ++k) {
+        for (const CGAL_Polyhedron& poly : P[k]) {
+          auto& partPoints = points[k].emplace_back();
+          partPoints.reserve(poly.size_of_vertices());
+          for (CGAL_Polyhedron::Vertex_const_iterator pi = poly.vertices_begin(); pi != poly.vertices_end(); ++pi) {
+            partPoints.push_back(conv(pi->point()));
+          }
+          hasHull[k].push_back(fastMinkowski && createConvexMinkowskiOperand(partPoints, hulls[k].emplace_back()));
+        }
+      }
+
       for (size_t i = 0; i < P[0].size(); ++i) {
         for (size_t j = 0; j < P[1].size(); ++j) {
           t.start();
-          points[0].clear();
-          points[1].clear();
-
-          for (int k = 0; k < 2; ++k) {
-            auto it = P[k].begin();
-            std::advance(it, k == 0?i:j);
-
-            CGAL_Polyhedron const& poly = *it;
-            points[k].reserve(poly.size_of_vertices());
-
-            for (CGAL_Polyhedron::Vertex_const_iterator pi = poly.vertices_begin(); pi != poly.vertices_end(); ++pi) {
-              CGAL_Polyhedron::Point_3 const& p = pi->point();
-              points[k].push_back(conv(p));
-            }
-          }
-
           minkowski_points.clear();
-          minkowski_points.reserve(points[0].size() * points[1].size());
-          for (size_t i = 0; i < points[0].size(); ++i) {
-            for (size_t j = 0; j < points[1].size(); ++j) {
-              minkowski_points.push_back(points[0][i] + (points[1][j] - CGAL::ORIGIN));
+          if (hasHull[0][i] && hasHull[1][j]) {
+            convexMinkowskiPoints(hulls[0][i], hulls[1][j], minkowski_points);
+          } else {
+            minkowski_points.reserve(points[0][i].size() * points[1][j].size());
+            for (const auto& p : points[0][i]) {
+              for (const auto& q : points[1][j]) {
+                minkowski_points.push_back(p + (q - CGAL::ORIGIN));
+              }
             }
           }
 
@@ -335,7 +454,7 @@ shared_ptr<const Geometry> applyMinkowski(const Geometry::Geometries& children)
 
           CGAL::Polyhedron_3<Hull_kernel> result;
           t.stop();
-          PRINTDB("Minkowski: Point cloud creation (%d ⨉ %d -> %d) took %f ms", points[0].size() % points[1].size() % minkowski_points.size() % (t.time() * 1000));
+          PRINTDB("Minkowski: Point cloud creation (%d ⨉ %d -> %d) took %f ms", points[0][i].size() % points[1][j].size() % minkowski_points.size() % (t.time() * 1000));
           t.reset();
 
           t.start();
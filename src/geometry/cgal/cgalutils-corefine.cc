@@ -2,9 +2,173 @@
 #include "cgalutils.h"
 
 #include "cgalutils-corefinement-visitor.h"
+#include "Trace.h"
+
+#include <CGAL/box_intersection_d.h>
+#include <CGAL/boost/graph/copy_face_graph.h>
+#include <CGAL/Polygon_mesh_processing/connected_components.h>
+#include <CGAL/Polygon_mesh_processing/orientation.h>
+#include <CGAL/Side_of_triangle_mesh.h>
+
+#include <numeric>
+#include <vector>
 
 namespace CGALUtils {
 
+namespace {
+
+template <class TriangleMesh>
+std::vector<CGAL::Bbox_3> getFaceBoundingBoxes(const TriangleMesh& mesh)
+{
+  std::vector<CGAL::Bbox_3> boxes;
+  boxes.reserve(mesh.number_of_faces());
+  for (auto f : mesh.faces()) {
+    auto h = mesh.halfedge(f);
+    CGAL::Bbox_3 box = mesh.point(mesh.target(h)).bbox();
+    for (auto v : CGAL::vertices_around_face(h, mesh)) box += mesh.point(v).bbox();
+    boxes.push_back(box);
+  }
+  return boxes;
+}
+
+struct OverlapFound {};
+
+/*!
+   Returns whether the bounding boxes of any face of one operand and any face
+   of the other overlap or touch. Only the faces within the bounds of the
+   other operand go into the box intersection tree, so checking a small
+   operand against a big one is about as cheap as a pass over the faces.
+ */
+bool anyFacesOverlap(const std::vector<CGAL::Bbox_3>& lhsBoxes, const std::vector<CGAL::Bbox_3>& rhsBoxes)
+{
+  const auto getBounds = [](const std::vector<CGAL::Bbox_3>& boxes) {
+      return std::accumulate(boxes.begin(), boxes.end(), boxes.front());
+    };
+  const auto lhsBounds = getBounds(lhsBoxes);
+  const auto rhsBounds = getBounds(rhsBoxes);
+  if (!CGAL::do_overlap(lhsBounds, rhsBounds)) return false;
+
+  using Box = CGAL::Box_intersection_d::Box_d<double, 3>;
+  const auto getBoxesWithin = [](const std::vector<CGAL::Bbox_3>& boxes, const CGAL::Bbox_3& bounds) {
+      std::vector<Box> result;
+      for (const auto& box : boxes) {
+        if (CGAL::do_overlap(box, bounds)) result.emplace_back(box);
+      }
+      return result;
+    };
+  auto lhsCandidates = getBoxesWithin(lhsBoxes, rhsBounds);
+  auto rhsCandidates = getBoxesWithin(rhsBoxes, lhsBounds);
+  if (lhsCandidates.empty() || rhsCandidates.empty()) return false;
+
+  try {
+    CGAL::box_intersection_d(lhsCandidates.begin(), lhsCandidates.end(),
+                             rhsCandidates.begin(), rhsCandidates.end(),
+                             [](const Box&, const Box&) { throw OverlapFound(); });
+  } catch (const OverlapFound&) {
+    return true;
+  }
+  return false;
+}
+
+/*!
+   Splits mesh into its connected components, such as the separate objects of
+   earlier unions or the shells of cavities, and returns for each whether it
+   lies within other. Knowing their surfaces don't intersect, a component is
+   on a single side of other, so testing one of its vertices is enough.
+   faceComponents receives the component of each face, by face index.
+ */
+template <class TriangleMesh>
+std::vector<bool> classifyComponents(const TriangleMesh& mesh, const TriangleMesh& other,
+                                     std::vector<std::size_t>& faceComponents)
+{
+  faceComponents.assign(mesh.num_faces(), 0);
+  auto fcm = boost::make_iterator_property_map(faceComponents.begin(), get(boost::face_index, mesh));
+  const auto numComponents = PMP::connected_components(mesh, fcm);
+
+  using Kernel = typename CGAL::Kernel_traits<typename TriangleMesh::Point>::Kernel;
+  CGAL::Side_of_triangle_mesh<TriangleMesh, Kernel> sideOfOther(other);
+  std::vector<bool> inside(numComponents);
+  std::vector<bool> tested(numComponents, false);
+  for (auto f : mesh.faces()) {
+    const auto component = faceComponents[f];
+    if (tested[component]) continue;
+    tested[component] = true;
+    inside[component] = sideOfOther(mesh.point(mesh.target(mesh.halfedge(f)))) == CGAL::ON_BOUNDED_SIDE;
+  }
+  return inside;
+}
+
+// Appends the components of mesh for which inside equals keepInside to out,
+// reversing their faces if requested.
+template <class TriangleMesh>
+void appendComponents(const TriangleMesh& mesh, const std::vector<bool>& inside,
+                      std::vector<std::size_t>& faceComponents, bool keepInside, bool reverse, TriangleMesh& out)
+{
+  std::vector<std::size_t> keep;
+  for (std::size_t component = 0; component < inside.size(); ++component) {
+    if (inside[component] == keepInside) keep.push_back(component);
+  }
+  if (keep.empty()) return;
+  if (keep.size() == inside.size() && !reverse) {
+    CGAL::copy_face_graph(mesh, out);
+    return;
+  }
+  // A copy has the same face indices, so faceComponents applies to it.
+  TriangleMesh part(mesh);
+  auto fcm = boost::make_iterator_property_map(faceComponents.begin(), get(boost::face_index, part));
+  if (keep.size() < inside.size()) PMP::keep_connected_components(part, keep, fcm);
+  if (reverse) PMP::reverse_face_orientations(part);
+  CGAL::copy_face_graph(part, out);
+}
+
+/*!
+   Computes lhs op rhs without corefinement when the surfaces of the operands
+   can't intersect, i.e. all their components are apart or nested. This is
+   the case of most unions of many objects. Returns false if corefinement is
+   needed.
+
+   The boundary of the result then consists of whole components of the
+   operands: for a union those outside the other operand, for an intersection
+   those inside it, and for a difference the components of lhs outside rhs
+   and, reversed, those of rhs inside lhs.
+ */
+template <class TriangleMesh>
+bool combineNonIntersecting(TriangleMesh& lhs, TriangleMesh& rhs, TriangleMesh& out, OpenSCADOperator op)
+{
+  if (op != OpenSCADOperator::UNION && op != OpenSCADOperator::INTERSECTION &&
+      op != OpenSCADOperator::DIFFERENCE) return false;
+  if (lhs.is_empty() || rhs.is_empty()) return false;
+  // Leave open meshes to the corefinement functions, which reject them.
+  if (!CGAL::is_closed(lhs) || !CGAL::is_closed(rhs)) return false;
+  if (anyFacesOverlap(getFaceBoundingBoxes(lhs), getFaceBoundingBoxes(rhs))) return false;
+
+  Trace::instant("csg", "non-intersecting operands");
+  std::vector<std::size_t> lhsComponents, rhsComponents;
+  const auto lhsInRhs = classifyComponents(lhs, rhs, lhsComponents);
+  const auto rhsInLhs = classifyComponents(rhs, lhs, rhsComponents);
+
+  // out may be one of the operands
+  TriangleMesh result;
+  switch (op) {
+  case OpenSCADOperator::UNION:
+    appendComponents(lhs, lhsInRhs, lhsComponents, false, false, result);
+    appendComponents(rhs, rhsInLhs, rhsComponents, false, false, result);
+    break;
+  case OpenSCADOperator::INTERSECTION:
+    appendComponents(lhs, lhsInRhs, lhsComponents, true, false, result);
+    appendComponents(rhs, rhsInLhs, rhsComponents, true, false, result);
+    break;
+  default:
+    appendComponents(lhs, lhsInRhs, lhsComponents, false, false, result);
+    appendComponents(rhs, rhsInLhs, rhsComponents, true, true, result);
+    break;
+  }
+  out = std::move(result);
+  return true;
+}
+
+} // namespace
+
 #if FAST_CSG_KERNEL_IS_LAZY
 
 /*! Visitor that forces exact numbers for the vertices of all the faces created during corefinement.
@@ -54,10 +218,11 @@ struct ExactLazyNumbersVisitor
 
 #endif// FAST_CSG_KERNEL_IS_LAZY
 
-#define COREFINEMENT_FUNCTION(functionName, cgalFunctionName) \
+#define COREFINEMENT_FUNCTION(functionName, cgalFunctionName, op) \
         template <class TriangleMesh> \
         bool functionName(TriangleMesh &lhs, TriangleMesh &rhs, TriangleMesh &out) \
         { \
+          if (combineNonIntersecting(lhs, rhs, out, op)) return true; \
           auto remesh = Feature::ExperimentalFastCsgRemesh.is_enabled() || Feature::ExperimentalFastCsgRemeshPredictibly.is_enabled(); \
           auto exactCallback = Feature::ExperimentalFastCsgExactCorefinementCallback.is_enabled(); \
           if (exactCallback && !remesh) { \
@@ -74,9 +239,9 @@ struct ExactLazyNumbersVisitor
           } \
         }
 
-COREFINEMENT_FUNCTION(corefineAndComputeUnion, PMP::corefine_and_compute_union);
-COREFINEMENT_FUNCTION(corefineAndComputeIntersection, PMP::corefine_and_compute_intersection);
-COREFINEMENT_FUNCTION(corefineAndComputeDifference, PMP::corefine_and_compute_difference);
+COREFINEMENT_FUNCTION(corefineAndComputeUnion, PMP::corefine_and_compute_union, OpenSCADOperator::UNION);
+COREFINEMENT_FUNCTION(corefineAndComputeIntersection, PMP::corefine_and_compute_intersection, OpenSCADOperator::INTERSECTION);
+COREFINEMENT_FUNCTION(corefineAndComputeDifference, PMP::corefine_and_compute_difference, OpenSCADOperator::DIFFERENCE);
 
 template bool corefineAndComputeUnion(CGAL_HybridMesh& lhs, CGAL_HybridMesh& rhs, CGAL_HybridMesh& out);
 template bool corefineAndComputeIntersection(CGAL_HybridMesh& lhs, CGAL_HybridMesh& rhs, CGAL_HybridMesh& out);
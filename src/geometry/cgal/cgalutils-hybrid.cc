@@ -10,7 +10,9 @@
 #include <CGAL/convex_hull_3.h>
 
 #include "CGAL_Nef_polyhedron.h"
+#include "CGALCache.h"
 #include "PolySetUtils.h"
+#include "Trace.h"
 
 namespace CGALUtils {
 
@@ -40,6 +42,8 @@ bool hasOnlyTriangles(const PolySet& ps) {
 
 std::shared_ptr<CGALHybridPolyhedron> createHybridPolyhedronFromPolySet(const PolySet& ps)
 {
+  Trace::Span span("conversion", "PolySet -> Hybrid");
+  span.arg("polygons", ps.polygons.size());
   // Since is_convex doesn't work well with non-planar faces,
   // we tessellate the polyset before checking.
   PolySet psq(ps);
@@ -84,6 +88,7 @@ std::shared_ptr<CGALHybridPolyhedron> createHybridPolyhedronFromPolySet(const Po
 
 std::shared_ptr<CGALHybridPolyhedron> createHybridPolyhedronFromNefPolyhedron(const CGAL_Nef_polyhedron& nef)
 {
+  Trace::Span span("conversion", "Nef -> Hybrid");
   assert(nef.p3);
 
   auto mesh = make_shared<CGAL_HybridMesh>();
@@ -99,10 +104,16 @@ std::shared_ptr<CGALHybridPolyhedron> createMutableHybridPolyhedronFromGeometry(
 {
   if (auto poly = dynamic_pointer_cast<const CGALHybridPolyhedron>(geom)) {
     return make_shared<CGALHybridPolyhedron>(*poly);
-  } else if (auto ps = dynamic_pointer_cast<const PolySet>(geom)) {
-    return createHybridPolyhedronFromPolySet(*ps);
-  } else if (auto nef = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
-    return createHybridPolyhedronFromNefPolyhedron(*nef);
+  } else if (dynamic_pointer_cast<const PolySet>(geom) || dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
+    // Copying a polyhedron converted before is cheaper than converting again
+    auto poly = CGALCache::instance()->convert<CGALHybridPolyhedron>(
+      geom, "Hybrid", [&]() -> shared_ptr<const CGALHybridPolyhedron> {
+      if (auto ps = dynamic_pointer_cast<const PolySet>(geom)) {
+        return createHybridPolyhedronFromPolySet(*ps);
+      }
+      return createHybridPolyhedronFromNefPolyhedron(*dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom));
+    });
+    return poly ? make_shared<CGALHybridPolyhedron>(*poly) : nullptr;
   } else {
     LOG(message_group::Warning, Location::NONE, "", "Unsupported geometry format.");
     return nullptr;
@@ -41,30 +41,37 @@ bool createMeshFromPolySet(const PolySet& ps, TriangleMesh& mesh)
 }
 
 template bool createMeshFromPolySet(const PolySet& ps, CGAL_HybridMesh& mesh);
+template bool createMeshFromPolySet(const PolySet& ps, CGAL::Surface_mesh<CGAL::Point_3<CGAL::Epick>>& mesh);
 
 template <class TriangleMesh>
 bool createPolySetFromMesh(const TriangleMesh& mesh, PolySet& ps)
 {
   bool err = false;
   ps.reserve(ps.numFacets() + mesh.number_of_faces());
+  // PolySet vertex of each mesh vertex, converted once and shared by its faces
+  std::vector<int> vertex_indices(mesh.number_of_vertices() + mesh.number_of_removed_vertices(), -1);
   for (auto& f : mesh.faces()) {
     ps.append_poly();
 
     CGAL::Vertex_around_face_iterator<TriangleMesh> vbegin, vend;
     for (boost::tie(vbegin, vend) = vertices_around_face(mesh.halfedge(f), mesh); vbegin != vend;
          ++vbegin) {
-      auto& v = mesh.point(*vbegin);
-      // for (auto &v : f) {
-      double x = CGAL::to_double(v.x());
-      double y = CGAL::to_double(v.y());
-      double z = CGAL::to_double(v.z());
-      ps.append_vertex(x, y, z);
+      auto& index = vertex_indices[static_cast<size_t>(*vbegin)];
+      if (index < 0) {
+        auto& v = mesh.point(*vbegin);
+        double x = CGAL::to_double(v.x());
+        double y = CGAL::to_double(v.y());
+        double z = CGAL::to_double(v.z());
+        index = ps.add_vertex(Vector3d(x, y, z));
+      }
+      ps.append_index(index);
     }
   }
   return err;
 }
 
 template bool createPolySetFromMesh(const CGAL_HybridMesh& mesh, PolySet& ps);
+template bool createPolySetFromMesh(const CGAL::Surface_mesh<CGAL::Point_3<CGAL::Epick>>& mesh, PolySet& ps);
 
 template <class InputKernel, class OutputKernel>
 void copyMesh(
@@ -1,6 +1,13 @@
-
 // Portions of this file are Copyright 2021 Google LLC, and licensed under GPL2+. See COPYING.
 #include "cgalutils.h"
+#include "Trace.h"
+
+#include <CGAL/convex_hull_3.h>
+#include <CGAL/Handle_hash_function.h>
+
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace CGALUtils {
 
@@ -16,4 +23,129 @@ template void inPlaceNefMinkowski(
   CGAL::Nef_polyhedron_3<CGAL_HybridKernel3>& lhs,
   CGAL::Nef_polyhedron_3<CGAL_HybridKernel3>& rhs);
 
+bool createConvexMinkowskiOperand(const std::vector<Vertex3K>& points, ConvexMinkowskiOperand& operand)
+{
+  using Polyhedron = CGAL::Polyhedron_3<K>;
+  Polyhedron hull;
+  CGAL::convex_hull_3(points.begin(), points.end(), hull);
+  // Flat hulls are open
+  if (hull.size_of_vertices() < 4 || !hull.is_closed()) return false;
+
+  std::unordered_map<Polyhedron::Vertex_const_handle, int, CGAL::Handle_hash_function> indices;
+  operand.vertices.clear();
+  operand.vertices.reserve(hull.size_of_vertices());
+  for (auto v = hull.vertices_begin(); v != hull.vertices_end(); ++v) {
+    indices.emplace(v, operand.vertices.size());
+    operand.vertices.push_back(vector_convert<Vector3d>(v->point()));
+  }
+  operand.neighbors.assign(operand.vertices.size(), {});
+  for (auto v = hull.vertices_begin(); v != hull.vertices_end(); ++v) {
+    auto& neighbors = operand.neighbors[indices[v]];
+    auto h = v->vertex_begin();
+    auto end = h;
+    CGAL_For_all(h, end) {
+      neighbors.push_back(indices[h->opposite()->vertex()]);
+    }
+  }
+  return true;
+}
+
+namespace {
+
+/*
+   Returns whether there is a direction d with d.dot(e) >= 0 for all edges e,
+   up to a tolerance.
+
+   If there is one, the cone of such directions is nonempty and one of its
+   extreme rays, or a line it contains, is orthogonal to two of the edges.
+   Edges are expected to be normalized.
+
+   Checking every candidate ray takes cubic time in the number of edges, so
+   vertex pairs with more edges than maxEdges are assumed to have one. This
+   only adds points inside or on the sum, which its hull removes.
+ */
+bool haveCommonSupportDirection(const std::vector<Vector3d>& edges)
+{
+  constexpr double tolerance = 1e-9;
+  constexpr size_t maxEdges = 24;
+  if (edges.size() > maxEdges) return true;
+  bool spanned = false;
+  for (size_t i = 0; i < edges.size(); ++i) {
+    for (size_t j = i + 1; j < edges.size(); ++j) {
+      Vector3d ray = edges[i].cross(edges[j]);
+      const double norm = ray.norm();
+      if (norm < tolerance) continue;
+      spanned = true;
+      ray /= norm;
+      for (int sign : {1, -1}) {
+        bool supported = true;
+        for (const auto& e : edges) {
+          if (sign * ray.dot(e) < -tolerance) {
+            supported = false;
+            break;
+          }
+        }
+        if (supported) return true;
+      }
+    }
+  }
+  // Parallel edges only
+  return !spanned;
+}
+
+} // namespace
+
+/*
+   Every vertex of a Minkowski sum of convex polyhedra is the sum of a vertex
+   of each operand which are extreme in a common direction, and its edges are
+   translated operand edges. Starting from the pair extreme in one direction,
+   the sum's vertices are found by walking along operand edges from pairs
+   which have a common support direction to their neighbors.
+
+   That direction is checked with a tolerance, so some other pairs touching the
+   boundary of the sum are added too. This keeps the walk connected across
+   coplanar operand faces, and a hull of the result removes them. Pairs with
+   many edges, such as those at the apex of a cone, are added unchecked.
+
+   This visits a number of pairs proportional to the size of the sum, rather
+   than to the product of the operand sizes.
+ */
+void convexMinkowskiPoints(const ConvexMinkowskiOperand& a, const ConvexMinkowskiOperand& b,
+                           std::vector<Vertex3K>& points)
+{
+  auto extreme = [](const std::vector<Vector3d>& vertices, const Vector3d& direction) {
+      int best = 0;
+      for (size_t i = 1; i < vertices.size(); ++i) {
+        if (vertices[i].dot(direction) > vertices[best].dot(direction)) best = i;
+      }
+      return best;
+    };
+  Trace::instant("minkowski", "edge walk");
+  // Any direction which isn't likely to be a face normal of the operands
+  const Vector3d start(0.5773, 0.5801, 0.5747);
+
+  auto key = [&](int i, int j) { return static_cast<size_t>(i) * b.vertices.size() + j; };
+  std::unordered_set<size_t> visited;
+  std::queue<std::pair<int, int>> queue;
+  std::vector<Vector3d> edges;
+
+  auto visit = [&](int i, int j) {
+      if (!visited.insert(key(i, j)).second) return;
+      edges.clear();
+      for (int n : a.neighbors[i]) edges.push_back((a.vertices[i] - a.vertices[n]).normalized());
+      for (int n : b.neighbors[j]) edges.push_back((b.vertices[j] - b.vertices[n]).normalized());
+      if (!haveCommonSupportDirection(edges)) return;
+      points.push_back(vector_convert<Vertex3K>(a.vertices[i] + b.vertices[j]));
+      queue.emplace(i, j);
+    };
+
+  visit(extreme(a.vertices, start), extreme(b.vertices, start));
+  while (!queue.empty()) {
+    auto [i, j] = queue.front();
+    queue.pop();
+    for (int n : a.neighbors[i]) visit(n, j);
+    for (int n : b.neighbors[j]) visit(i, n);
+  }
+}
+
 } // namespace CGALUtils
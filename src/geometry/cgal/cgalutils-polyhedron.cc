@@ -8,6 +8,7 @@
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 
 #include <boost/range/adaptor/reversed.hpp>
+#include <unordered_map>
 
 #undef GEN_SURFACE_DEBUG
 namespace /* anonymous */ {
@@ -284,16 +285,23 @@ bool createPolySetFromPolyhedron(const Polyhedron& p, PolySet& ps)
   using FCI = typename Polyhedron::Facet_const_iterator;
   using HFCC = typename Polyhedron::Halfedge_around_facet_const_circulator;
 
+  // PolySet vertex of each polyhedron vertex, converted once and shared by its facets
+  std::unordered_map<const Vertex *, int> vertex_indices;
+  vertex_indices.reserve(p.size_of_vertices());
   for (FCI fi = p.facets_begin(); fi != p.facets_end(); ++fi) {
     HFCC hc = fi->facet_begin();
     HFCC hc_end = hc;
     ps.append_poly();
     do {
       Vertex const& v = *((hc++)->vertex());
-      double x = CGAL::to_double(v.point().x());
-      double y = CGAL::to_double(v.point().y());
-      double z = CGAL::to_double(v.point().z());
-      ps.append_vertex(x, y, z);
+      auto inserted = vertex_indices.emplace(&v, 0);
+      if (inserted.second) {
+        double x = CGAL::to_double(v.point().x());
+        double y = CGAL::to_double(v.point().y());
+        double z = CGAL::to_double(v.point().z());
+        inserted.first->second = ps.add_vertex(Vector3d(x, y, z));
+      }
+      ps.append_index(inserted.first->second);
     } while (hc != hc_end);
   }
   return err;
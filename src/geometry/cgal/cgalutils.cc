@@ -11,6 +11,7 @@
 #include "PolySetUtils.h"
 #include "node.h"
 #include "degree_trig.h"
+#include "Trace.h"
 
 #include <CGAL/Aff_transformation_3.h>
 #include <CGAL/normal_vector_newell_3.h>
@@ -25,6 +26,7 @@
 #include "Reindexer.h"
 #include "GeometryUtils.h"
 #include "CGALHybridPolyhedron.h"
+#include "CGALCache.h"
 
 #include <map>
 #include <queue>
@@ -239,16 +241,23 @@ bool is_approximately_convex(const PolySet& ps) {
 
 shared_ptr<const CGAL_Nef_polyhedron> getNefPolyhedronFromGeometry(const shared_ptr<const Geometry>& geom)
 {
-  if (auto ps = dynamic_pointer_cast<const PolySet>(geom)) {
-    return shared_ptr<CGAL_Nef_polyhedron>(createNefPolyhedronFromPolySet(*ps));
-  } else if (auto poly = dynamic_pointer_cast<const CGALHybridPolyhedron>(geom)) {
-    return createNefPolyhedronFromHybrid(*poly);
-  } else if (auto poly2d = dynamic_pointer_cast<const Polygon2d>(geom)) {
-    return shared_ptr<CGAL_Nef_polyhedron>(createNefPolyhedronFromPolygon2d(*poly2d));
-  } else if (auto nef = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
-    return nef;
-  }
-  return nullptr;
+  if (auto nef = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) return nef;
+  if (!geom) return nullptr;
+  return CGALCache::instance()->convert<CGAL_Nef_polyhedron>(
+    geom, "Nef", [&]() -> shared_ptr<const CGAL_Nef_polyhedron> {
+    if (auto ps = dynamic_pointer_cast<const PolySet>(geom)) {
+      Trace::Span span("conversion", "PolySet -> Nef");
+      span.arg("polygons", ps->polygons.size());
+      return shared_ptr<CGAL_Nef_polyhedron>(createNefPolyhedronFromPolySet(*ps));
+    } else if (auto poly = dynamic_pointer_cast<const CGALHybridPolyhedron>(geom)) {
+      Trace::Span span("conversion", "Hybrid -> Nef");
+      return createNefPolyhedronFromHybrid(*poly);
+    } else if (auto poly2d = dynamic_pointer_cast<const Polygon2d>(geom)) {
+      Trace::Span span("conversion", "Polygon2d -> Nef");
+      return shared_ptr<CGAL_Nef_polyhedron>(createNefPolyhedronFromPolygon2d(*poly2d));
+    }
+    return nullptr;
+  });
 }
 
 /*
@@ -375,11 +384,15 @@ bool createPolySetFromNefPolyhedron3(const CGAL::Nef_polyhedron_3<K>& N, PolySet
     LOG(message_group::Error, Location::NONE, "", "Non-manifold mesh created: %1$d unconnected edges", unconnected2);
   }
 
+  // Triangles share the vertices of the indexed mesh
+  ps.reserve(ps.numFacets() + allTriangles.size());
+  const int base = ps.polygons.vertices.size();
+  for (const auto& v : verts) ps.add_vertex(v.cast<double>());
   for (const auto& t : allTriangles) {
     ps.append_poly();
-    ps.append_vertex(verts[t[0]]);
-    ps.append_vertex(verts[t[1]]);
-    ps.append_vertex(verts[t[2]]);
+    ps.append_index(base + t[0]);
+    ps.append_index(base + t[1]);
+    ps.append_index(base + t[2]);
   }
 
 #if 0 // For debugging
@@ -484,21 +497,27 @@ shared_ptr<const PolySet> getGeometryAsPolySet(const shared_ptr<const Geometry>&
   if (auto ps = dynamic_pointer_cast<const PolySet>(geom)) {
     return ps;
   }
-  if (auto N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
-    auto ps = make_shared<PolySet>(3);
-    ps->setConvexity(N->getConvexity());
-    if (!N->isEmpty()) {
-      bool err = CGALUtils::createPolySetFromNefPolyhedron3(*N->p3, *ps);
-      if (err) {
-        LOG(message_group::Error, Location::NONE, "", "Nef->PolySet failed.");
+  if (!geom) return nullptr;
+  return CGALCache::instance()->convert<PolySet>(
+    geom, "PolySet", [&]() -> shared_ptr<const PolySet> {
+    if (auto N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
+      Trace::Span span("conversion", "Nef -> PolySet");
+      auto ps = make_shared<PolySet>(3);
+      ps->setConvexity(N->getConvexity());
+      if (!N->isEmpty()) {
+        bool err = CGALUtils::createPolySetFromNefPolyhedron3(*N->p3, *ps);
+        if (err) {
+          LOG(message_group::Error, Location::NONE, "", "Nef->PolySet failed.");
+        }
       }
+      return ps;
     }
-    return ps;
-  }
-  if (auto hybrid = dynamic_pointer_cast<const CGALHybridPolyhedron>(geom)) {
-    return hybrid->toPolySet();
-  }
-  return nullptr;
+    if (auto hybrid = dynamic_pointer_cast<const CGALHybridPolyhedron>(geom)) {
+      Trace::Span span("conversion", "Hybrid -> PolySet");
+      return hybrid->toPolySet();
+    }
+    return nullptr;
+  });
 }
 
 }  // namespace CGALUtils
@@ -41,6 +41,12 @@ shared_ptr<CGALHybridPolyhedron> applyOperator3DHybrid(const Geometry::Geometrie
 shared_ptr<CGALHybridPolyhedron> applyUnion3DHybrid(
   const Geometry::Geometries::const_iterator& chbegin,
   const Geometry::Geometries::const_iterator& chend);
+bool applyOperator3DDouble(const Geometry::Geometries& children, OpenSCADOperator op,
+                           shared_ptr<const Geometry>& result);
+bool applyUnion3DDouble(
+  const Geometry::Geometries::const_iterator& chbegin,
+  const Geometry::Geometries::const_iterator& chend,
+  shared_ptr<const Geometry>& result);
 //FIXME: Old, can be removed:
 //void applyBinaryOperator(CGAL_Nef_polyhedron &target, const CGAL_Nef_polyhedron &src, OpenSCADOperator op);
 Polygon2d *project(const CGAL_Nef_polyhedron& N, bool cut);
@@ -126,6 +132,17 @@ template <typename K>
 void inPlaceNefIntersection(CGAL::Nef_polyhedron_3<K>& lhs, const CGAL::Nef_polyhedron_3<K>& rhs);
 template <typename K>
 void inPlaceNefMinkowski(CGAL::Nef_polyhedron_3<K>& lhs, CGAL::Nef_polyhedron_3<K>& rhs);
+// A convex polyhedron with the neighbors of each vertex, for convexMinkowskiPoints().
+struct ConvexMinkowskiOperand {
+  std::vector<Vector3d> vertices;
+  std::vector<std::vector<int>> neighbors;
+};
+// Builds an operand from the hull of points. Returns false if they are coplanar.
+bool createConvexMinkowskiOperand(const std::vector<Vertex3K>& points, ConvexMinkowskiOperand& operand);
+// Appends the vertices of the Minkowski sum of a and b to points, along with
+// a few other points of the sum, which its hull leaves out.
+void convexMinkowskiPoints(const ConvexMinkowskiOperand& a, const ConvexMinkowskiOperand& b,
+                           std::vector<Vertex3K>& points);
 template <typename K>
 void convertNefToPolyhedron(const CGAL::Nef_polyhedron_3<K>& nef, CGAL::Polyhedron_3<K>& polyhedron);
 template <class TriangleMesh>
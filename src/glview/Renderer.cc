@@ -346,8 +346,7 @@ void Renderer::render_surface(const PolySet& ps, csgmode_e csgmode, const Transf
     } else {
       // If we don't have borders, use the polygons as borders.
       // FIXME: When is this used?
-      const Polygons *borders_p = &ps.polygons;
-      for (const auto& poly : *borders_p) {
+      for (const auto& poly : ps.polygons) {
         for (size_t j = 1; j <= poly.size(); ++j) {
           Vector3d p1 = poly.at(j - 1), p2 = poly.at(j - 1);
           Vector3d p3 = poly.at(j % poly.size()), p4 = poly.at(j % poly.size());
@@ -427,9 +426,8 @@ void Renderer::render_edges(const PolySet& ps, csgmode_e csgmode) const
     }
   } else if (ps.getDimension() == 3) {
     for (const auto& polygon : ps.polygons) {
-      const Polygon *poly = &polygon;
       glBegin(GL_LINE_LOOP);
-      for (const auto& p : *poly) {
+      for (const auto& p : polygon) {
         glVertex3d(p[0], p[1], p[2]);
       }
       glEnd();
@@ -29,6 +29,7 @@
 #include "CommentParser.h"
 #include "openscad.h"
 #include "GeometryCache.h"
+#include "PrimitiveTemplateCache.h"
 #include "SourceFileCache.h"
 #include "MainWindow.h"
 #include "OpenSCADApp.h"
@@ -2646,6 +2647,7 @@ void MainWindow::actionCopyViewport()
 void MainWindow::actionFlushCaches()
 {
   GeometryCache::instance()->clear();
+  PrimitiveTemplateCache::instance()->clear();
 #ifdef ENABLE_CGAL
   CGALCache::instance()->clear();
 #endif
@@ -28,6 +28,7 @@
 #include "PolySet.h"
 #include "printutils.h"
 #include "Geometry.h"
+#include "Trace.h"
 
 #include <fstream>
 
@@ -50,6 +51,8 @@ bool canPreview(const FileFormat format) {
 
 void exportFile(const shared_ptr<const Geometry>& root_geom, std::ostream& output, const ExportInfo& exportInfo)
 {
+  Trace::Span span("export", "exportFile");
+  span.arg("file", exportInfo.name2display);
   switch (exportInfo.format) {
   case FileFormat::ASCIISTL:
     export_stl(root_geom, output, false);
@@ -1,5 +1,6 @@
 #include "export.h"
 #include "printutils.h"
+#include "Trace.h"
 #include "OffscreenView.h"
 #include "CsgInfo.h"
 #include <cstdio>
@@ -19,6 +20,7 @@ static void setupCamera(Camera& cam, const BoundingBox& bbox)
 bool export_png(const shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera, std::ostream& output)
 {
   PRINTD("export_png geom");
+  Trace::Span span("export", "export_png");
   OffscreenView *glview;
   try {
     glview = new OffscreenView(camera.pixel_width, camera.pixel_height);
@@ -98,6 +100,7 @@ std::unique_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& op
 bool export_png(const OffscreenView& glview, std::ostream& output)
 {
   PRINTD("export_png_preview_common");
+  Trace::Span span("export", "export_png");
   glview.save(output);
   return true;
 }
@@ -44,6 +44,8 @@
 #include "OffscreenView.h"
 #include "GeometryEvaluator.h"
 #include "RenderStatistic.h"
+#include "EvaluationProfiler.h"
+#include "Trace.h"
 #include "ParameterObject.h"
 #include "ParameterSet.h"
 #include "openscad_mimalloc.h"
@@ -960,6 +962,9 @@ int main(int argc, char **argv)
     ("csglimit", po::value<unsigned int>(), "=n -stop rendering at n CSG elements when exporting png")
     ("summary", po::value<vector<string>>(), "enable additional render summary and statistics: all | cache | time | camera | geometry | bounding-box | area")
     ("summary-file", po::value<string>(), "output summary information in JSON format to the given file, using '-' outputs to stdout")
+    ("profile-eval", po::value<string>(), "profile evaluation of functions and modules, output in JSON format to the given file, using '-' outputs to stdout")
+    ("profile-eval-folded", po::value<string>(), "profile evaluation of functions and modules, output call stacks in folded flamegraph format to the given file")
+    ("trace-file", po::value<string>(), "record a timeline of parsing, evaluation, geometry and export in Chrome trace event format to the given file")
     ("colorscheme", po::value<string>(), ("=colorscheme: " +
                                           str_join(ColorMap::inst()->colorSchemeNames(), " | ",
                                                    [](const std::string& colorScheme) {
@@ -1160,6 +1165,12 @@ int main(int argc, char **argv)
 
   if (arg_info || cmdlinemode) {
     if (inputFiles.size() > 1) help(argv[0], desc, true);
+    if (vm.count("profile-eval") || vm.count("profile-eval-folded")) {
+      EvaluationProfiler::enable();
+    }
+    if (vm.count("trace-file")) {
+      Trace::enable();
+    }
     try {
       parser_init();
       localization_init();
@@ -1193,6 +1204,30 @@ int main(int argc, char **argv)
       rc = 1;
     }
 
+    if (vm.count("trace-file")) {
+      const auto& trace_file = vm["trace-file"].as<string>();
+      with_output(trace_file == "-", trace_file, [](std::ostream& stream) {
+        Trace::write(stream);
+      });
+    }
+
+    if (const auto *profiler = EvaluationProfiler::instance()) {
+      const bool has_file = !inputFiles.empty() && inputFiles[0] != "-";
+      const auto doc_path = has_file ? fs::absolute(fs::path(inputFiles[0])).parent_path() : original_path;
+      if (vm.count("profile-eval")) {
+        const auto& profile_file = vm["profile-eval"].as<string>();
+        with_output(profile_file == "-", profile_file, [profiler, &doc_path](std::ostream& stream) {
+          profiler->writeJson(stream, doc_path.string());
+        });
+      }
+      if (vm.count("profile-eval-folded")) {
+        const auto& profile_file = vm["profile-eval-folded"].as<string>();
+        with_output(profile_file == "-", profile_file, [profiler](std::ostream& stream) {
+          profiler->writeFolded(stream);
+        });
+      }
+    }
+
     if (deps_output_file) {
       std::string deps_out(deps_output_file);
       const vector<std::string>& geom_out(output_files);
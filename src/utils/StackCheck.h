@@ -6,9 +6,10 @@
 class StackCheck
 {
 public:
+  // One instance per thread, as each thread has its own stack.
   static StackCheck& inst()
   {
-    static StackCheck instance;
+    thread_local StackCheck instance;
     return instance;
   }
 
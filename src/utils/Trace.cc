@@ -0,0 +1,109 @@
+#include "Trace.h"
+
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <json.hpp>
+
+std::atomic<bool> Trace::active{false};
+
+namespace {
+
+std::mutex mutex;
+std::vector<Trace::Event> events;
+std::map<int, std::string> thread_names;
+Trace::clock::time_point epoch;
+std::atomic<int> next_thread_id{1};
+
+nlohmann::json toJson(const Trace::Args& args)
+{
+  nlohmann::json json = nlohmann::json::object();
+  for (const auto& arg : args) json[arg.first] = arg.second;
+  return json;
+}
+
+} // namespace
+
+void Trace::enable()
+{
+  if (active) return;
+  epoch = clock::now();
+  threadId(); // the enabling thread is the main one
+  active = true;
+}
+
+int Trace::threadId()
+{
+  thread_local int id = 0;
+  if (id == 0) {
+    id = next_thread_id++;
+    std::lock_guard<std::mutex> lock(mutex);
+    thread_names[id] = id == 1 ? "main" : "worker " + std::to_string(id - 1);
+  }
+  return id;
+}
+
+double Trace::microseconds(clock::time_point time)
+{
+  return std::chrono::duration<double, std::micro>(time - epoch).count();
+}
+
+void Trace::record(Event event)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  events.push_back(std::move(event));
+}
+
+void Trace::instant(const char *category, const char *name)
+{
+  if (!enabled()) return;
+  record(Event{name, category, 'i', microseconds(clock::now()), 0, threadId(), {}});
+}
+
+void Trace::instant(const char *category, const char *name, const char *key, const std::string& value)
+{
+  if (!enabled()) return;
+  // Values such as cache keys can be whole subtrees, so keep only their start.
+  record(Event{name, category, 'i', microseconds(clock::now()), 0, threadId(), {{key, value.substr(0, 80)}}});
+}
+
+void Trace::Span::start(const char *category, std::string name)
+{
+  if (!enabled()) return;
+  this->recording = true;
+  this->category = category;
+  this->name = std::move(name);
+  this->begin = clock::now();
+}
+
+void Trace::Span::finish()
+{
+  if (!recording) return;
+  recording = false;
+  const double timestamp = microseconds(begin);
+  const double duration = microseconds(clock::now()) - timestamp;
+  record(Event{std::move(name), category, 'X', timestamp, duration, threadId(), std::move(args)});
+}
+
+void Trace::write(std::ostream& stream)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  nlohmann::json trace_events = nlohmann::json::array();
+  for (const auto& thread : thread_names) {
+    trace_events.push_back({
+      {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", thread.first},
+      {"args", {{"name", thread.second}}},
+    });
+  }
+  for (const auto& event : events) {
+    nlohmann::json json = {
+      {"name", event.name}, {"cat", event.category}, {"ph", std::string(1, event.phase)},
+      {"ts", event.timestamp}, {"pid", 1}, {"tid", event.thread},
+    };
+    if (event.phase == 'X') json["dur"] = event.duration;
+    else json["s"] = "t"; // instant events are scoped to their thread
+    if (!event.args.empty()) json["args"] = toJson(event.args);
+    trace_events.push_back(std::move(json));
+  }
+  stream << nlohmann::json{{"traceEvents", trace_events}, {"displayTimeUnit", "ms"}}.dump() << "\n";
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Records a timeline of the render pipeline, enabled by --trace-file.
+ *
+ * Events are written in the Chrome trace event format, which can be opened
+ * with chrome://tracing or https://ui.perfetto.dev. Each event carries the id
+ * of the thread it was recorded on, so work done on worker threads shows up
+ * on its own track. When tracing is disabled, a span costs a flag check.
+ */
+class Trace
+{
+public:
+  using clock = std::chrono::steady_clock;
+  using Args = std::vector<std::pair<const char *, std::string>>;
+
+  struct Event {
+    std::string name;
+    const char *category;
+    char phase;
+    double timestamp; // microseconds since tracing was enabled
+    double duration;
+    int thread;
+    Args args;
+  };
+
+  static bool enabled() { return active.load(std::memory_order_relaxed); }
+  static void enable();
+  static void write(std::ostream& stream);
+
+  // Records an event without duration, such as a cache hit.
+  static void instant(const char *category, const char *name);
+  static void instant(const char *category, const char *name, const char *key, const std::string& value);
+
+  // Records the lifetime of the span as a complete event.
+  class Span
+  {
+public:
+    Span() = default;
+    Span(const char *category, const char *name) {
+      if (enabled()) start(category, name);
+    }
+    ~Span() { finish(); }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    // Starts recording a default constructed span, for names that are only
+    // worth building when tracing is enabled.
+    void start(const char *category, std::string name);
+
+    // Arguments are shown with the event; they are dropped if not recording.
+    void arg(const char *key, const std::string& value) {
+      if (recording) args.emplace_back(key, value);
+    }
+    void arg(const char *key, size_t value) {
+      if (recording) args.emplace_back(key, std::to_string(value));
+    }
+    void finish();
+
+private:
+    bool recording = false;
+    const char *category = nullptr;
+    std::string name;
+    Args args;
+    clock::time_point begin;
+  };
+
+private:
+  static void record(Event event);
+  static double microseconds(clock::time_point time);
+  static int threadId();
+
+  static std::atomic<bool> active;
+};
@@ -2,6 +2,8 @@
 
 #include "linalg.h"
 
+#include <cstdint>
+
 using Vector3l = Eigen::Matrix<int64_t, 3, 1>;
 
 namespace std {
@@ -15,3 +17,15 @@ size_t hash_value(Vector3f const& v);
 size_t hash_value(Vector3d const& v);
 size_t hash_value(Vector3l const& v);
 }
+
+// Spreads every bit of h over the whole result (the MurmurHash3 finalizer),
+// for hash tables indexed by the low bits of hashes.
+inline uint64_t hash_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
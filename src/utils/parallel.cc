@@ -0,0 +1,64 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <vector>
+#include <boost/thread.hpp>
+
+#include "PlatformUtils.h"
+#include "StackCheck.h"
+
+namespace {
+thread_local bool worker = false;
+}
+
+namespace Parallel {
+
+unsigned int concurrency()
+{
+  const unsigned int threads = boost::thread::hardware_concurrency();
+  return threads > 0 ? threads : 1;
+}
+
+bool isWorker()
+{
+  return worker;
+}
+
+void run(size_t count, const std::function<void(size_t)>& task)
+{
+  std::vector<std::exception_ptr> errors(count);
+  boost::thread::attributes attributes;
+  attributes.set_stack_size(PlatformUtils::stackLimit() + STACK_BUFFER_SIZE);
+
+  std::atomic<size_t> next{0};
+  const size_t numThreads = std::min<size_t>(count, concurrency());
+  std::vector<boost::thread> threads;
+  threads.reserve(numThreads);
+  try {
+    for (size_t i = 0; i < numThreads; ++i) {
+      threads.emplace_back(attributes, [&task, &errors, &next, count]() {
+        worker = true;
+        StackCheck::inst();
+        for (size_t index = next++; index < count; index = next++) {
+          try {
+            task(index);
+          } catch (...) {
+            errors[index] = std::current_exception();
+          }
+        }
+      });
+    }
+  } catch (...) {
+    for (auto& thread : threads) thread.join();
+    throw;
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (const auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+}
+
+} // namespace Parallel
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace Parallel {
+// Number of threads worth running at once, at least 1.
+unsigned int concurrency();
+
+// True on threads started by run().
+bool isWorker();
+
+/*
+ * Runs task(0) .. task(count - 1) on at most concurrency() worker threads,
+ * each taking the next task until none are left, and waits for all of them
+ * to finish. Worker threads get the same stack size as the main thread, so
+ * StackCheck limits deep recursion the same way on both.
+ * If any task throws, the exception of the lowest numbered one is rethrown.
+ */
+void run(size_t count, const std::function<void(size_t)>& task);
+}
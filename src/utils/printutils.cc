@@ -123,6 +123,43 @@ void PRINT_NOCACHE(const Message& msgObj)
   }
 }
 
+namespace {
+thread_local std::vector<Message> *captured_messages = nullptr;
+}
+
+void LOG(Message&& msgObj)
+{
+  if (captured_messages) {
+    captured_messages->push_back(std::move(msgObj));
+    return;
+  }
+
+  //check for deprecations
+  if (msgObj.group == message_group::Deprecated) {
+    if (!printedDeprecations.insert(msgObj.msg + msgObj.loc.toRelativeString(msgObj.docPath)).second) return;
+  }
+
+  PRINT(msgObj);
+}
+
+MessageCapture::MessageCapture(std::vector<Message>& messages) : previous(captured_messages)
+{
+  captured_messages = &messages;
+}
+
+MessageCapture::~MessageCapture()
+{
+  captured_messages = previous;
+}
+
+void print_captured_messages(std::vector<Message>& messages)
+{
+  for (auto& msgObj : messages) {
+    LOG(std::move(msgObj));
+  }
+  messages.clear();
+}
+
 void PRINTDEBUG(const std::string& filename, const std::string& msg)
 {
   // see printutils.h for usage instructions
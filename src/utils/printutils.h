@@ -2,6 +2,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include <iostream>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
@@ -214,17 +215,31 @@ public:
 
 extern std::set<std::string> printedDeprecations;
 
+void LOG(Message&& msgObj);
+
 template <typename F, typename ... Args>
 void LOG(const message_group& msg_grp, Location loc, std::string docPath, F&& f, Args&&... args)
 {
   const auto msg = MessageClass<Args...>(std::forward<F>(f), std::forward<Args>(args)...);
-  auto formatted = msg.format();
+  LOG(Message{msg.format(), std::move(loc), std::move(docPath), msg_grp});
+}
 
-  //check for deprecations
-  if (msg_grp == message_group::Deprecated && printedDeprecations.find(formatted + loc.toRelativeString(docPath)) != printedDeprecations.end()) return;
-  if (msg_grp == message_group::Deprecated) printedDeprecations.insert(formatted + loc.toRelativeString(docPath));
+/*
+ * While a MessageCapture exists, messages logged on its thread are collected
+ * instead of printed. Worker threads use this to hand their messages back to
+ * the main thread, which prints them in evaluation order using
+ * print_captured_messages().
+ */
+class MessageCapture
+{
+public:
+  MessageCapture(std::vector<Message>& messages);
+  ~MessageCapture();
+  MessageCapture(const MessageCapture&) = delete;
+  MessageCapture& operator=(const MessageCapture&) = delete;
 
-  Message msgObj{std::move(formatted), std::move(loc), std::move(docPath), msg_grp};
+private:
+  std::vector<Message> *previous;
+};
 
-  PRINT(msgObj);
-}
+void print_captured_messages(std::vector<Message>& messages);
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+
+# Feature comparison test
+#
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> --feature=<feature> [--feature=<feature> ...]
+#                 [--trace=<category>:<name> ...] [<openscad args>] file.txt
+#
+#
+# step 1. Run OpenSCAD on the .scad file, exporting STL without the given features
+# step 2. Run OpenSCAD again with the given features enabled, recording the given trace events
+# step 3. Compare volume, surface area and bounding box of both results, and write the
+#         outcome and which of the trace events were recorded to file.txt
+# step 4. (done in CTest) - compare the generated .txt file to expected output
+#
+# Features which the test framework enables for all tests, such as fast-csg, are
+# disabled for the first run if they are compared.
+#
+# This script should return 0 on success, not-0 on error.
+
+from __future__ import print_function
+
+import sys, os, json, math, struct, subprocess, argparse
+
+# Relative to the size of the bounding box
+TOLERANCE = 1e-6
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('feature_compare_test args:', str(sys.argv), file=sys.stderr)
+    print('exiting feature_compare_test.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def read_triangles(filename):
+    with open(filename, 'rb') as f: data = f.read()
+    if data.startswith(b'solid') and b'endsolid' in data[-200:]:
+        points = []
+        for line in data.decode('ascii').splitlines():
+            parts = line.split()
+            if parts and parts[0] == 'vertex':
+                points.append(tuple(float(x) for x in parts[1:4]))
+        if len(points) % 3 != 0: failquit('incomplete facet in ' + filename)
+        return [points[i:i+3] for i in range(0, len(points), 3)]
+    count = struct.unpack('<I', data[80:84])[0]
+    triangles = []
+    for i in range(count):
+        values = struct.unpack('<12f', data[84 + i*50 : 84 + i*50 + 48])
+        triangles.append([values[3:6], values[6:9], values[9:12]])
+    return triangles
+
+def measure(filename):
+    volume = 0.0
+    area = 0.0
+    lower = [math.inf] * 3
+    upper = [-math.inf] * 3
+    for a, b, c in read_triangles(filename):
+        volume += (a[0] * (b[1] * c[2] - b[2] * c[1]) -
+                   a[1] * (b[0] * c[2] - b[2] * c[0]) +
+                   a[2] * (b[0] * c[1] - b[1] * c[0])) / 6
+        u = [b[i] - a[i] for i in range(3)]
+        v = [c[i] - a[i] for i in range(3)]
+        n = [u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]]
+        area += math.sqrt(sum(x * x for x in n)) / 2
+        for p in (a, b, c):
+            for i in range(3):
+                lower[i] = min(lower[i], p[i])
+                upper[i] = max(upper[i], p[i])
+    return {'volume': volume, 'area': area, 'lower': lower, 'upper': upper}
+
+def matches(m1, m2):
+    if math.isinf(m1['lower'][0]) or math.isinf(m2['lower'][0]):
+        return math.isinf(m1['lower'][0]) and math.isinf(m2['lower'][0])
+    size = max(max(m1['upper'][i] - m1['lower'][i] for i in range(3)), 1e-9)
+    return (abs(m1['volume'] - m2['volume']) <= TOLERANCE * size**3 and
+            abs(m1['area'] - m2['area']) <= TOLERANCE * size**2 and
+            all(abs(m1[key][i] - m2[key][i]) <= TOLERANCE * size for key in ('lower', 'upper') for i in range(3)))
+
+def describe(measurements):
+    return 'volume=%r area=%r bounds=%r..%r' % (measurements['volume'], measurements['area'],
+                                                measurements['lower'], measurements['upper'])
+
+def run_openscad(cmd):
+    print('Running OpenSCAD:', ' '.join(cmd), file=sys.stderr)
+    fontdir = os.path.abspath(os.path.join(os.path.dirname(__file__), "data/ttf"))
+    fontenv = os.environ.copy()
+    fontenv["OPENSCAD_FONT_PATH"] = fontdir
+    result = subprocess.call(cmd, env=fontenv)
+    if result != 0:
+        failquit('OpenSCAD failed with return code ' + str(result))
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+parser.add_argument('--feature', required=True, action='append', help='Feature to compare with and without')
+parser.add_argument('--trace', action='append', default=[], help='Trace event <category>:<name> to look for with the features enabled')
+args, remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+txtfile = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit("can't find input file named: " + inputfile)
+if not os.path.exists(args.openscad):
+    failquit("can't find openscad executable named: " + args.openscad)
+
+outputdir = os.path.dirname(txtfile)
+inputbasename = os.path.splitext(os.path.split(inputfile)[1])[0]
+without_file = os.path.join(outputdir, inputbasename + '-without.stl')
+with_file = os.path.join(outputdir, inputbasename + '-with.stl')
+trace_file = os.path.join(outputdir, inputbasename + '-with-trace.json')
+
+enables = ['--enable=' + feature for feature in args.feature]
+without_args = [arg for arg in remaining_args if arg not in enables]
+with_args = without_args + enables
+if args.trace: with_args.append('--trace-file=' + trace_file)
+
+run_openscad([args.openscad, inputfile, '-o', without_file] + without_args)
+run_openscad([args.openscad, inputfile, '-o', with_file] + with_args)
+
+recorded = set()
+if args.trace:
+    with open(trace_file) as f:
+        for event in json.load(f)['traceEvents']:
+            if 'cat' in event: recorded.add(event['cat'] + ':' + event['name'])
+
+without_measurements = measure(without_file)
+with_measurements = measure(with_file)
+with open(txtfile, 'w') as f:
+    if matches(without_measurements, with_measurements):
+        print(' '.join(enables) + ': same volume, area and bounds', file=f)
+    else:
+        print(' '.join(enables) + ': results differ', file=f)
+        print('without: ' + describe(without_measurements), file=f)
+        print('with: ' + describe(with_measurements), file=f)
+    for event in args.trace:
+        print('trace ' + event + ': ' + ('recorded' if event in recorded else 'not recorded'), file=f)
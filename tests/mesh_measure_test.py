@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+
+# Mesh measurement test
+#
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] file.txt
+#
+#
+# step 1. Run OpenSCAD on the .scad file, exporting STL
+# step 2. Write the volume and bounding box of the mesh, rounded, to file.txt
+# step 3. (done in CTest) - compare the generated .txt file to expected output
+#
+# This checks results which can be worked out by hand, such as the area of a
+# polygon extruded to a height of 1, independently of how they are triangulated.
+#
+# This script should return 0 on success, not-0 on error.
+
+from __future__ import print_function
+
+import sys, os, math, struct, subprocess, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('mesh_measure_test args:', str(sys.argv), file=sys.stderr)
+    print('exiting mesh_measure_test.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def read_triangles(filename):
+    with open(filename, 'rb') as f: data = f.read()
+    if data.startswith(b'solid') and b'endsolid' in data[-200:]:
+        points = []
+        for line in data.decode('ascii').splitlines():
+            parts = line.split()
+            if parts and parts[0] == 'vertex':
+                points.append(tuple(float(x) for x in parts[1:4]))
+        if len(points) % 3 != 0: failquit('incomplete facet in ' + filename)
+        return [points[i:i+3] for i in range(0, len(points), 3)]
+    count = struct.unpack('<I', data[80:84])[0]
+    triangles = []
+    for i in range(count):
+        values = struct.unpack('<12f', data[84 + i*50 : 84 + i*50 + 48])
+        triangles.append([values[3:6], values[6:9], values[9:12]])
+    return triangles
+
+def rounded(value):
+    # Avoids printing -0.0000
+    return '%.4f' % (round(value, 4) + 0.0)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+args, remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+txtfile = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit("can't find input file named: " + inputfile)
+if not os.path.exists(args.openscad):
+    failquit("can't find openscad executable named: " + args.openscad)
+
+outputdir = os.path.dirname(txtfile)
+inputbasename = os.path.splitext(os.path.split(inputfile)[1])[0]
+stlfile = os.path.join(outputdir, inputbasename + '-measure.stl')
+
+export_cmd = [args.openscad, inputfile, '-o', stlfile] + remaining_args
+print('Running OpenSCAD:', ' '.join(export_cmd), file=sys.stderr)
+result = subprocess.call(export_cmd)
+if result != 0:
+    failquit('OpenSCAD failed with return code ' + str(result))
+
+volume = 0.0
+lower = [math.inf] * 3
+upper = [-math.inf] * 3
+for a, b, c in read_triangles(stlfile):
+    volume += (a[0] * (b[1] * c[2] - b[2] * c[1]) -
+               a[1] * (b[0] * c[2] - b[2] * c[0]) +
+               a[2] * (b[0] * c[1] - b[1] * c[0])) / 6
+    for p in (a, b, c):
+        for i in range(3):
+            lower[i] = min(lower[i], p[i])
+            upper[i] = max(upper[i], p[i])
+if math.isinf(lower[0]):
+    failquit('no triangles in ' + stlfile)
+
+with open(txtfile, 'w') as f:
+    print('volume: ' + rounded(volume), file=f)
+    print('bounds: [' + ', '.join(rounded(x) for x in lower) + '] .. [' + ', '.join(rounded(x) for x in upper) + ']', file=f)
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+
+# Evaluation profiler test
+#
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] file.txt
+#
+#
+# step 1. Run OpenSCAD on the .scad file with --profile-eval and --profile-eval-folded
+# step 2. Check that both outputs are well formed and refer to the same definitions
+# step 3. Write the parts that don't depend on timing (definitions and call counts) to file.txt
+# step 4. (done in CTest) - compare the generated .txt file to expected output
+#
+# This script should return 0 on success, not-0 on error.
+
+from __future__ import print_function
+
+import sys, os, re, json, subprocess, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('profile_eval_test args:', str(sys.argv), file=sys.stderr)
+    print('exiting profile_eval_test.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def check_entry(entry):
+    for key, kind in [('kind', str), ('name', str), ('calls', int), ('values', int),
+                      ('inclusive_ms', (int, float)), ('exclusive_ms', (int, float))]:
+        if not isinstance(entry.get(key), kind):
+            failquit('invalid or missing "' + key + '" in profile entry:', entry)
+    if entry['calls'] < 1 or entry['values'] < 0:
+        failquit('invalid counts in profile entry:', entry)
+    if entry['exclusive_ms'] < 0 or entry['exclusive_ms'] > entry['inclusive_ms'] + 1e-3:
+        failquit('exclusive time not within inclusive time in profile entry:', entry)
+    if ('file' in entry) != ('line' in entry):
+        failquit('"file" and "line" must be given together in profile entry:', entry)
+
+def frame_name(entry):
+    frame = entry['name']
+    if 'line' in entry: frame += ':' + str(entry['line'])
+    return frame.replace(';', ',').replace(' ', '_')
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+args, remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+txtfile = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit("can't find input file named: " + inputfile)
+if not os.path.exists(args.openscad):
+    failquit("can't find openscad executable named: " + args.openscad)
+
+outputdir = os.path.dirname(txtfile)
+inputbasename = os.path.splitext(os.path.split(inputfile)[1])[0]
+echofile = os.path.join(outputdir, inputbasename + '-profile.echo')
+jsonfile = os.path.join(outputdir, inputbasename + '-profile.json')
+foldedfile = os.path.join(outputdir, inputbasename + '-profile.folded')
+
+profile_cmd = [args.openscad, inputfile, '-o', echofile,
+               '--profile-eval=' + jsonfile, '--profile-eval-folded=' + foldedfile] + remaining_args
+print('Running OpenSCAD:', ' '.join(profile_cmd), file=sys.stderr)
+result = subprocess.call(profile_cmd)
+if result != 0:
+    failquit('OpenSCAD failed with return code ' + str(result))
+
+try:
+    with open(jsonfile) as f: profile = json.load(f)
+except (OSError, ValueError) as err:
+    failquit('could not read profile ' + jsonfile + ': ' + str(err))
+if not isinstance(profile, dict) or not isinstance(profile.get('profile'), list):
+    failquit('expected an object with a "profile" list in ' + jsonfile)
+entries = profile['profile']
+for entry in entries: check_entry(entry)
+exclusive = [entry['exclusive_ms'] for entry in entries]
+if exclusive != sorted(exclusive, reverse=True):
+    failquit('profile entries are not sorted by exclusive time')
+
+frames = set(frame_name(entry) for entry in entries)
+folded_re = re.compile(r'^([^ ]+) ([1-9][0-9]*)$')
+with open(foldedfile) as f:
+    for line in f.read().splitlines():
+        match = folded_re.match(line)
+        if not match:
+            failquit('invalid line in folded profile:', line)
+        for frame in match.group(1).split(';'):
+            if frame not in frames:
+                failquit('folded profile frame "' + frame + '" is not in the JSON profile')
+
+with open(txtfile, 'w') as f:
+    for entry in sorted(entries, key=lambda e: (e['kind'], e['name'], e.get('line', 0))):
+        location = ' ' + entry['file'] + ':' + str(entry['line']) if 'line' in entry else ''
+        print(entry['kind'] + ' ' + entry['name'] + location + ' calls=' + str(entry['calls']), file=f)
+    print('folded profile: valid', file=f)
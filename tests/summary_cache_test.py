@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+
+# Cache summary test
+#
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] file.txt
+#
+#
+# step 1. Run OpenSCAD on the .scad file, exporting STL with --summary cache and --summary-file
+# step 2. Check that each cache has well formed totals, and entries and bytes by kind which add up to them
+# step 3. Write the primitive template cache entries by kind, which don't depend on the
+#         CSG backend, to file.txt
+# step 4. (done in CTest) - compare the generated .txt file to expected output
+#
+# This script should return 0 on success, not-0 on error.
+
+from __future__ import print_function
+
+import sys, os, json, subprocess, argparse
+
+# Caches reported in all builds; cgal_cache is only there with CGAL.
+CACHES = ['geometry_cache', 'primitive_cache']
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('summary_cache_test args:', str(sys.argv), file=sys.stderr)
+    print('exiting summary_cache_test.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def check_cache(name, cache):
+    for key in ['entries', 'bytes', 'max_size']:
+        if not isinstance(cache.get(key), int) or cache[key] < 0:
+            failquit('invalid or missing "' + key + '" in ' + name + ':', cache)
+    kinds = cache.get('kinds')
+    if not isinstance(kinds, dict):
+        failquit('invalid or missing "kinds" in ' + name + ':', cache)
+    for kind, usage in kinds.items():
+        if not isinstance(usage.get('entries'), int) or usage['entries'] < 1 or \
+           not isinstance(usage.get('bytes'), int) or usage['bytes'] < 0:
+            failquit('invalid kind "' + kind + '" in ' + name + ':', usage)
+    for key in ['entries', 'bytes']:
+        if sum(usage[key] for usage in kinds.values()) != cache[key]:
+            failquit('"' + key + '" of the kinds in ' + name + ' do not add up to its total:', cache)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+args, remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+txtfile = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit("can't find input file named: " + inputfile)
+if not os.path.exists(args.openscad):
+    failquit("can't find openscad executable named: " + args.openscad)
+
+outputdir = os.path.dirname(txtfile)
+inputbasename = os.path.splitext(os.path.split(inputfile)[1])[0]
+stlfile = os.path.join(outputdir, inputbasename + '-summary.stl')
+summaryfile = os.path.join(outputdir, inputbasename + '-summary.json')
+
+summary_cmd = [args.openscad, inputfile, '-o', stlfile, '--summary', 'cache', '--summary-file', summaryfile] + remaining_args
+print('Running OpenSCAD:', ' '.join(summary_cmd), file=sys.stderr)
+result = subprocess.call(summary_cmd)
+if result != 0:
+    failquit('OpenSCAD failed with return code ' + str(result))
+
+try:
+    with open(summaryfile) as f: summary = json.load(f)
+except (OSError, ValueError) as err:
+    failquit('could not read summary ' + summaryfile + ': ' + str(err))
+caches = summary.get('cache') if isinstance(summary, dict) else None
+if not isinstance(caches, dict):
+    failquit('expected an object with a "cache" object in ' + summaryfile)
+for name in CACHES:
+    if name not in caches:
+        failquit('missing "' + name + '" in ' + summaryfile)
+for name, cache in caches.items():
+    check_cache(name, cache)
+
+with open(txtfile, 'w') as f:
+    print('caches: valid', file=f)
+    for kind, usage in sorted(caches['primitive_cache']['kinds'].items()):
+        print('primitive_cache ' + kind + ': entries=' + str(usage['entries']), file=f)
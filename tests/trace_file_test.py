@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+
+# Trace file test
+#
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] file.txt
+#
+#
+# step 1. Run OpenSCAD on the .scad file, exporting STL with --trace-file
+# step 2. Check that the trace is well formed Chrome trace event JSON
+# step 3. Write the parts that don't depend on timing or caching to file.txt
+# step 4. (done in CTest) - compare the generated .txt file to expected output
+#
+# This script should return 0 on success, not-0 on error.
+
+from __future__ import print_function
+
+import sys, os, json, subprocess, argparse
+
+# Categories used by Trace::Span and Trace::instant(). Keep in sync with the sources.
+CATEGORIES = ['cache', 'conversion', 'csg', 'evaluation', 'export', 'geometry', 'minkowski', 'parse']
+
+# Spans recorded for every file exported from the command line.
+REQUIRED_SPANS = [
+    ('parse', 'parse'),
+    ('evaluation', 'SourceFile::instantiate'),
+    ('geometry', 'evaluateGeometry'),
+    ('export', 'exportFile'),
+]
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('trace_file_test args:', str(sys.argv), file=sys.stderr)
+    print('exiting trace_file_test.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def check_event(event):
+    for key, kind in [('name', str), ('ph', str), ('pid', int), ('tid', int)]:
+        if not isinstance(event.get(key), kind):
+            failquit('invalid or missing "' + key + '" in trace event:', event)
+    if event['ph'] == 'M':
+        if event['name'] != 'thread_name' or not isinstance(event.get('args', {}).get('name'), str):
+            failquit('invalid metadata event:', event)
+        return
+    if event['ph'] not in ('X', 'i'):
+        failquit('unexpected phase in trace event:', event)
+    if event.get('cat') not in CATEGORIES:
+        failquit('unknown category in trace event:', event)
+    if not isinstance(event.get('ts'), (int, float)) or event['ts'] < 0:
+        failquit('invalid timestamp in trace event:', event)
+    if event['ph'] == 'X' and (not isinstance(event.get('dur'), (int, float)) or event['dur'] < 0):
+        failquit('invalid duration in trace event:', event)
+    if event['ph'] == 'i' and event.get('s') != 't':
+        failquit('instant event not scoped to its thread:', event)
+    if 'args' in event and not all(isinstance(value, str) for value in event['args'].values()):
+        failquit('non-string argument in trace event:', event)
+
+def check_nesting(spans):
+    # Spans are scoped, so those on one thread are either nested or disjoint.
+    epsilon = 0.01
+    open_ends = []
+    for span in sorted(spans, key=lambda s: (s['ts'], -s['dur'])):
+        end = span['ts'] + span['dur']
+        while open_ends and open_ends[-1] <= span['ts'] + epsilon: open_ends.pop()
+        if open_ends and end > open_ends[-1] + epsilon:
+            failquit('span overlaps the end of its enclosing span:', span)
+        open_ends.append(end)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+args, remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+txtfile = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit("can't find input file named: " + inputfile)
+if not os.path.exists(args.openscad):
+    failquit("can't find openscad executable named: " + args.openscad)
+
+outputdir = os.path.dirname(txtfile)
+inputbasename = os.path.splitext(os.path.split(inputfile)[1])[0]
+stlfile = os.path.join(outputdir, inputbasename + '-trace.stl')
+tracefile = os.path.join(outputdir, inputbasename + '-trace.json')
+
+trace_cmd = [args.openscad, inputfile, '-o', stlfile, '--trace-file=' + tracefile] + remaining_args
+print('Running OpenSCAD:', ' '.join(trace_cmd), file=sys.stderr)
+result = subprocess.call(trace_cmd)
+if result != 0:
+    failquit('OpenSCAD failed with return code ' + str(result))
+
+try:
+    with open(tracefile) as f: trace = json.load(f)
+except (OSError, ValueError) as err:
+    failquit('could not read trace ' + tracefile + ': ' + str(err))
+if not isinstance(trace, dict) or not isinstance(trace.get('traceEvents'), list):
+    failquit('expected an object with a "traceEvents" list in ' + tracefile)
+if trace.get('displayTimeUnit') not in ('ms', 'ns'):
+    failquit('invalid displayTimeUnit in ' + tracefile)
+
+events = trace['traceEvents']
+for event in events: check_event(event)
+thread_names = {event['tid']: event['args']['name'] for event in events if event['ph'] == 'M'}
+spans_by_thread = {}
+for event in events:
+    if event['ph'] == 'M': continue
+    if event['tid'] not in thread_names:
+        failquit('trace event on unnamed thread:', event)
+    if event['ph'] == 'X': spans_by_thread.setdefault(event['tid'], []).append(event)
+for spans in spans_by_thread.values(): check_nesting(spans)
+
+names = set((event['cat'], event['name']) for event in events if event['ph'] == 'X')
+nodes = set()
+for event in events:
+    if event['ph'] == 'X' and event['cat'] == 'geometry' and 'file' in event.get('args', {}):
+        nodes.add((event['args']['file'], int(event['args']['line']), event['name']))
+
+with open(txtfile, 'w') as f:
+    print('trace events: valid', file=f)
+    print('main thread: ' + ('named' if 'main' in thread_names.values() else 'missing'), file=f)
+    for span in REQUIRED_SPANS:
+        print('span ' + ' '.join(span) + ': ' + ('present' if span in names else 'missing'), file=f)
+    for node in sorted(nodes):
+        print('node ' + node[2] + ' ' + node[0] + ':' + str(node[1]), file=f)